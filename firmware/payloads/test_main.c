@@ -9,28 +9,68 @@
 
 #include <sbi/sbi_ecall_interface.h>
 
-#define SBI_ECALL(__num, __a0, __a1, __a2)                                    \
+#define SBI_ECALL_FID(__num, __fid, __a0, __a1, __a2)                         \
 	({                                                                    \
 		register unsigned long a0 asm("a0") = (unsigned long)(__a0);  \
 		register unsigned long a1 asm("a1") = (unsigned long)(__a1);  \
 		register unsigned long a2 asm("a2") = (unsigned long)(__a2);  \
+		register unsigned long a6 asm("a6") = (unsigned long)(__fid); \
 		register unsigned long a7 asm("a7") = (unsigned long)(__num); \
 		asm volatile("ecall"                                          \
-			     : "+r"(a0)                                       \
-			     : "r"(a1), "r"(a2), "r"(a7)                      \
+			     : "+r"(a0), "+r"(a1)                             \
+			     : "r"(a2), "r"(a6), "r"(a7)                      \
 			     : "memory");                                     \
 		a0;                                                           \
 	})
 
+#define SBI_ECALL(__num, __a0, __a1, __a2) \
+	SBI_ECALL_FID(__num, 0, __a0, __a1, __a2)
+
 #define SBI_ECALL_0(__num) SBI_ECALL(__num, 0, 0, 0)
 #define SBI_ECALL_1(__num, __a0) SBI_ECALL(__num, __a0, 0, 0)
 #define SBI_ECALL_2(__num, __a0, __a1) SBI_ECALL(__num, __a0, __a1, 0)
 
 #define sbi_ecall_console_putc(c) SBI_ECALL_1(SBI_EXT_0_1_CONSOLE_PUTCHAR, (c))
 
+/* Debug console write, returns the SBI error and the bytes written */
+static inline long sbi_ecall_dbcn_write(const char *str, unsigned long len,
+					unsigned long *written)
+{
+	register unsigned long a0 asm("a0") = len;
+	register unsigned long a1 asm("a1") = (unsigned long)str;
+	register unsigned long a2 asm("a2") = 0;
+	register unsigned long a6 asm("a6") = SBI_EXT_DBCN_CONSOLE_WRITE;
+	register unsigned long a7 asm("a7") = SBI_EXT_DBCN;
+
+	asm volatile("ecall"
+		     : "+r"(a0), "+r"(a1)
+		     : "r"(a2), "r"(a6), "r"(a7)
+		     : "memory");
+	*written = a1;
+
+	return (long)a0;
+}
+
 static inline void sbi_ecall_console_puts(const char *str)
 {
-	while (str && *str)
+	unsigned long len = 0, written;
+
+	while (str && str[len])
+		len++;
+
+	/*
+	 * Payload runs with translation off, so the address is physical.
+	 * Each call writes a bounded chunk, so continue from where it
+	 * stopped and only fall back to putchar on an error.
+	 */
+	while (len) {
+		if (sbi_ecall_dbcn_write(str, len, &written) || !written)
+			break;
+		str += written;
+		len -= written;
+	}
+
+	while (len--)
 		sbi_ecall_console_putc(*str++);
 }
 
@@ -10,6 +10,10 @@
 #ifndef __RISCV_ATOMIC_H__
 #define __RISCV_ATOMIC_H__
 
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_bits.h>
+
 typedef struct {
 	volatile long counter;
 } atomic_t;
@@ -21,50 +25,247 @@ typedef struct {
 		.counter = (val), \
 	}
 
-long atomic_read(atomic_t *atom);
+/*
+ * Atomic operations
+ *
+ * Every read-modify-write operation comes in four orderings selected by
+ * the function name suffix:
+ *   _relaxed : atomicity only
+ *   _acquire : later accesses are not reordered before the operation
+ *   _release : earlier accesses are not reordered after the operation
+ *   (none)   : fully ordered
+ * Fetch operations map to a single XLEN sized AMO while compare-and-swap
+ * uses an LR/SC loop. Everything is inline so hot paths pay neither a
+ * call nor a stronger fence than they ask for.
+ */
+
+/* clang-format off */
+
+#if __riscv_xlen == 64
+#define __ATOMIC_LONG_SFX	".d"
+#elif __riscv_xlen == 32
+#define __ATOMIC_LONG_SFX	".w"
+#else
+#error "Unexpected __riscv_xlen"
+#endif
+
+/* clang-format on */
+
+#define __ATOMIC_RAW_FETCH_OP(op, asm_op, ord, sfx)                        \
+	static inline unsigned long atomic_raw_fetch_##op##_ulong##sfx(     \
+		volatile unsigned long *ptr, unsigned long val)            \
+	{                                                                  \
+		unsigned long ret;                                         \
+		__asm__ __volatile__("	amo" #asm_op __ATOMIC_LONG_SFX ord \
+				     " %0, %2, %1"                         \
+				     : "=r"(ret), "+A"(*ptr)               \
+				     : "r"(val)                            \
+				     : "memory");                          \
+		return ret;                                                \
+	}
+
+#define __ATOMIC_RAW_CMPXCHG(lr_ord, sc_ord, fence, sfx)                    \
+	static inline unsigned long atomic_raw_cmpxchg_ulong##sfx(          \
+		volatile unsigned long *ptr, unsigned long oldval,         \
+		unsigned long newval)                                      \
+	{                                                                  \
+		unsigned long ret;                                         \
+		unsigned int rc;                                           \
+		__asm__ __volatile__(                                      \
+			"0:	lr" __ATOMIC_LONG_SFX lr_ord " %0, %2\n"   \
+			"	bne	%0, %z3, 1f\n"                     \
+			"	sc" __ATOMIC_LONG_SFX sc_ord " %1, %z4, %2\n" \
+			"	bnez	%1, 0b\n"                          \
+			fence                                              \
+			"1:\n"                                             \
+			: "=&r"(ret), "=&r"(rc), "+A"(*ptr)                \
+			: "rJ"(oldval), "rJ"(newval)                       \
+			: "memory");                                       \
+		return ret;                                                \
+	}
+
+#define __ATOMIC_RAW_ORDERS(gen, ...)             \
+	gen(__VA_ARGS__, "", _relaxed)            \
+	gen(__VA_ARGS__, ".aq", _acquire)         \
+	gen(__VA_ARGS__, ".rl", _release)         \
+	gen(__VA_ARGS__, ".aqrl", )
+
+__ATOMIC_RAW_ORDERS(__ATOMIC_RAW_FETCH_OP, add, add)
+__ATOMIC_RAW_ORDERS(__ATOMIC_RAW_FETCH_OP, and, and)
+__ATOMIC_RAW_ORDERS(__ATOMIC_RAW_FETCH_OP, or, or)
+__ATOMIC_RAW_ORDERS(__ATOMIC_RAW_FETCH_OP, xor, xor)
+__ATOMIC_RAW_ORDERS(__ATOMIC_RAW_FETCH_OP, xchg, swap)
+
+__ATOMIC_RAW_CMPXCHG("", "", "", _relaxed)
+__ATOMIC_RAW_CMPXCHG(".aq", "", "", _acquire)
+__ATOMIC_RAW_CMPXCHG("", ".rl", "", _release)
+__ATOMIC_RAW_CMPXCHG("", ".rl", "	fence	rw, rw\n", )
+
+#define __ATOMIC_OPS(op, sfx)                                              \
+	static inline long atomic_fetch_##op##sfx(atomic_t *atom, long val) \
+	{                                                                  \
+		return (long)atomic_raw_fetch_##op##_ulong##sfx(           \
+			(volatile unsigned long *)&atom->counter, val);    \
+	}
+
+#define __ATOMIC_RETURN_OPS(sfx)                                           \
+	static inline long atomic_fetch_sub##sfx(atomic_t *atom, long val)  \
+	{                                                                  \
+		return atomic_fetch_add##sfx(atom, -val);                  \
+	}                                                                  \
+	static inline long atomic_add_return##sfx(atomic_t *atom, long val) \
+	{                                                                  \
+		return atomic_fetch_add##sfx(atom, val) + val;             \
+	}                                                                  \
+	static inline long atomic_sub_return##sfx(atomic_t *atom, long val) \
+	{                                                                  \
+		return atomic_fetch_add##sfx(atom, -val) - val;            \
+	}                                                                  \
+	static inline long atomic_xchg##sfx(atomic_t *atom, long newval)    \
+	{                                                                  \
+		return (long)atomic_raw_fetch_xchg_ulong##sfx(             \
+			(volatile unsigned long *)&atom->counter, newval); \
+	}                                                                  \
+	static inline long atomic_cmpxchg##sfx(atomic_t *atom, long oldval, \
+					       long newval)                \
+	{                                                                  \
+		return (long)atomic_raw_cmpxchg_ulong##sfx(                \
+			(volatile unsigned long *)&atom->counter, oldval,  \
+			newval);                                           \
+	}
+
+#define __ATOMIC_ORDERS(gen, ...)        \
+	gen(__VA_ARGS__ _relaxed)        \
+	gen(__VA_ARGS__ _acquire)        \
+	gen(__VA_ARGS__ _release)        \
+	gen(__VA_ARGS__)
 
-void atomic_write(atomic_t *atom, long value);
+__ATOMIC_ORDERS(__ATOMIC_OPS, add,)
+__ATOMIC_ORDERS(__ATOMIC_OPS, and,)
+__ATOMIC_ORDERS(__ATOMIC_OPS, or,)
+__ATOMIC_ORDERS(__ATOMIC_OPS, xor,)
+__ATOMIC_ORDERS(__ATOMIC_RETURN_OPS)
 
-long atomic_add_return(atomic_t *atom, long value);
+#undef __ATOMIC_RAW_FETCH_OP
+#undef __ATOMIC_RAW_CMPXCHG
+#undef __ATOMIC_RAW_ORDERS
+#undef __ATOMIC_OPS
+#undef __ATOMIC_RETURN_OPS
+#undef __ATOMIC_ORDERS
 
-long atomic_sub_return(atomic_t *atom, long value);
+static inline long atomic_read(atomic_t *atom)
+{
+	long ret = atom->counter;
+	rmb();
+	return ret;
+}
 
-long arch_atomic_cmpxchg(atomic_t *atom, long oldval, long newval);
+static inline void atomic_write(atomic_t *atom, long value)
+{
+	atom->counter = value;
+	wmb();
+}
 
-long arch_atomic_xchg(atomic_t *atom, long newval);
+static inline long arch_atomic_cmpxchg(atomic_t *atom, long oldval,
+				       long newval)
+{
+	return atomic_cmpxchg(atom, oldval, newval);
+}
 
-unsigned int atomic_raw_xchg_uint(volatile unsigned int *ptr,
-				  unsigned int newval);
+static inline long arch_atomic_xchg(atomic_t *atom, long newval)
+{
+	return atomic_xchg(atom, newval);
+}
+
+static inline unsigned long atomic_raw_xchg_ulong(volatile unsigned long *ptr,
+						  unsigned long newval)
+{
+	return atomic_raw_fetch_xchg_ulong(ptr, newval);
+}
+
+static inline unsigned long
+atomic_raw_xchg_ulong_acquire(volatile unsigned long *ptr,
+			      unsigned long newval)
+{
+	return atomic_raw_fetch_xchg_ulong_acquire(ptr, newval);
+}
+
+static inline unsigned int atomic_raw_xchg_uint(volatile unsigned int *ptr,
+						unsigned int newval)
+{
+	unsigned int ret;
+
+	__asm__ __volatile__("	amoswap.w.aqrl	%0, %2, %1\n"
+			     : "=r"(ret), "+A"(*ptr)
+			     : "r"(newval)
+			     : "memory");
+
+	return ret;
+}
 
-unsigned long atomic_raw_xchg_ulong(volatile unsigned long *ptr,
-				    unsigned long newval);
 /**
- * Set a bit in an atomic variable and return the new value.
+ * Set a bit in any address and return the old word value.
  * @nr : Bit to set.
- * @atom: atomic variable to modify
+ * @addr: Address to modify
  */
-int atomic_set_bit(int nr, atomic_t *atom);
+static inline int atomic_raw_set_bit(int nr, volatile unsigned long *addr)
+{
+	return atomic_raw_fetch_or_ulong(&addr[BIT_WORD(nr)], BIT_MASK(nr));
+}
 
 /**
- * Clear a bit in an atomic variable and return the new value.
+ * Set a bit in any address with release ordering only.
  * @nr : Bit to set.
- * @atom: atomic variable to modify
+ * @addr: Address to modify
  */
+static inline int atomic_raw_set_bit_release(int nr,
+					     volatile unsigned long *addr)
+{
+	return atomic_raw_fetch_or_ulong_release(&addr[BIT_WORD(nr)],
+						 BIT_MASK(nr));
+}
 
-int atomic_clear_bit(int nr, atomic_t *atom);
+/**
+ * Clear a bit in any address and return the old word value.
+ * @nr : Bit to clear.
+ * @addr: Address to modify
+ */
+static inline int atomic_raw_clear_bit(int nr, volatile unsigned long *addr)
+{
+	return atomic_raw_fetch_and_ulong(&addr[BIT_WORD(nr)], ~BIT_MASK(nr));
+}
 
 /**
- * Set a bit in any address and return the new value .
- * @nr : Bit to set.
+ * Clear a bit in any address with release ordering only.
+ * @nr : Bit to clear.
  * @addr: Address to modify
  */
-int atomic_raw_set_bit(int nr, volatile unsigned long *addr);
+static inline int atomic_raw_clear_bit_release(int nr,
+					       volatile unsigned long *addr)
+{
+	return atomic_raw_fetch_and_ulong_release(&addr[BIT_WORD(nr)],
+						  ~BIT_MASK(nr));
+}
 
 /**
- * Clear a bit in any address and return the new value .
+ * Set a bit in an atomic variable and return the old value.
  * @nr : Bit to set.
- * @addr: Address to modify
+ * @atom: atomic variable to modify
+ */
+static inline int atomic_set_bit(int nr, atomic_t *atom)
+{
+	return atomic_raw_set_bit(nr, (volatile unsigned long *)&atom->counter);
+}
+
+/**
+ * Clear a bit in an atomic variable and return the old value.
+ * @nr : Bit to clear.
+ * @atom: atomic variable to modify
  */
-int atomic_raw_clear_bit(int nr, volatile unsigned long *addr);
+static inline int atomic_clear_bit(int nr, atomic_t *atom)
+{
+	return atomic_raw_clear_bit(nr,
+				    (volatile unsigned long *)&atom->counter);
+}
 
 #endif
@@ -103,6 +103,15 @@
 #define SATP64_ASID			_ULL(0x0FFFF00000000000)
 #define SATP64_PPN			_ULL(0x00000FFFFFFFFFFF)
 
+#define HGATP32_MODE			_UL(0x80000000)
+#define HGATP32_VMID_SHIFT		22
+#define HGATP32_VMID_MASK		_UL(0x1FC00000)
+#define HGATP32_PPN			_UL(0x003FFFFF)
+#define HGATP64_MODE			_ULL(0xF000000000000000)
+#define HGATP64_VMID_SHIFT		44
+#define HGATP64_VMID_MASK		_ULL(0x03FFF00000000000)
+#define HGATP64_PPN			_ULL(0x00000FFFFFFFFFFF)
+
 #define SATP_MODE_OFF			_UL(0)
 #define SATP_MODE_SV32			_UL(1)
 #define SATP_MODE_SV39			_UL(8)
@@ -143,11 +152,15 @@
 #define SSTATUS_SD			SSTATUS64_SD
 #define RISCV_PGLEVEL_BITS		9
 #define SATP_MODE			SATP64_MODE
+#define HGATP_VMID_SHIFT		HGATP64_VMID_SHIFT
+#define HGATP_VMID_MASK			HGATP64_VMID_MASK
 #else
 #define MSTATUS_SD			MSTATUS32_SD
 #define SSTATUS_SD			SSTATUS32_SD
 #define RISCV_PGLEVEL_BITS		10
 #define SATP_MODE			SATP32_MODE
+#define HGATP_VMID_SHIFT		HGATP32_VMID_SHIFT
+#define HGATP_VMID_MASK			HGATP32_VMID_MASK
 #endif
 #define RISCV_PGSHIFT			12
 #define RISCV_PGSIZE			(1 << RISCV_PGSHIFT)
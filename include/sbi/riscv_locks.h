@@ -10,19 +10,74 @@
 #ifndef __RISCV_LOCKS_H__
 #define __RISCV_LOCKS_H__
 
+#include <sbi/riscv_barrier.h>
+#include <sbi/sbi_types.h>
+
+#ifdef SBI_LOCK_STATS
+/*
+ * Lock statistics (SBI_LOCK_STATS=y)
+ *
+ * All counters are updated by the lock holder so they need no atomics.
+ * Hold times are in mcycle units. A lock is added to the global table
+ * on its first acquisition.
+ */
+struct spinlock_stats {
+	const char *name;
+	unsigned long acquired;
+	unsigned long contended;
+	unsigned long spins;
+	unsigned long max_hold;
+	unsigned long hold_start;
+	bool registered;
+};
+#endif
+
+/*
+ * Ticket spinlock
+ *
+ * A HART takes a ticket by incrementing 'next' and owns the lock once
+ * 'owner' reaches its ticket, so the lock is handed over in FIFO order.
+ * Both tickets share one 32-bit word which is updated atomically.
+ */
 typedef struct {
-	volatile long lock;
-} spinlock_t;
+	volatile u16 owner;
+	volatile u16 next;
+#ifdef SBI_LOCK_STATS
+	struct spinlock_stats stats;
+#endif
+} __attribute__((aligned(4))) spinlock_t;
 
 #define __RISCV_SPIN_UNLOCKED 0
 
-#define SPIN_LOCK_INIT(_lptr) (_lptr)->lock = __RISCV_SPIN_UNLOCKED
+#ifdef SBI_LOCK_STATS
+void spin_lock_stats_init(spinlock_t *lock, const char *name);
+
+#define __SPIN_LOCK_STATS_INIT(_lptr, _name) \
+	spin_lock_stats_init(_lptr, _name)
+#define __SPIN_LOCK_STATS_INITIALIZER(_name) .stats = { .name = _name },
+#else
+#define __SPIN_LOCK_STATS_INIT(_lptr, _name)
+#define __SPIN_LOCK_STATS_INITIALIZER(_name)
+#endif
+
+#define SPIN_LOCK_NAMED_INIT(_lptr, _name)           \
+	do {                                         \
+		(_lptr)->owner = __RISCV_SPIN_UNLOCKED; \
+		(_lptr)->next  = __RISCV_SPIN_UNLOCKED; \
+		__SPIN_LOCK_STATS_INIT(_lptr, _name); \
+	} while (0)
+
+#define SPIN_LOCK_INIT(_lptr) SPIN_LOCK_NAMED_INIT(_lptr, NULL)
 
-#define SPIN_LOCK_INITIALIZER                  \
-	{                                      \
-		.lock = __RISCV_SPIN_UNLOCKED, \
+#define SPIN_LOCK_NAMED_INITIALIZER(_name)      \
+	{                                       \
+		.owner = __RISCV_SPIN_UNLOCKED, \
+		.next  = __RISCV_SPIN_UNLOCKED, \
+		__SPIN_LOCK_STATS_INITIALIZER(_name) \
 	}
 
+#define SPIN_LOCK_INITIALIZER SPIN_LOCK_NAMED_INITIALIZER(NULL)
+
 int spin_lock_check(spinlock_t *lock);
 
 int spin_trylock(spinlock_t *lock);
@@ -31,4 +86,111 @@ void spin_lock(spinlock_t *lock);
 
 void spin_unlock(spinlock_t *lock);
 
+#ifdef SBI_LOCK_STATS
+/** Maximum number of locks tracked by the lock statistics table */
+#define SPIN_LOCK_STATS_MAX 32
+
+u32 spin_lock_stats_count(void);
+
+const struct spinlock_stats *spin_lock_stats_get(u32 index);
+
+void spin_lock_stats_reset(void);
+
+void spin_lock_stats_dump(void);
+#endif
+
+/*
+ * Reader-writer lock
+ *
+ * The lock word counts active readers or is __RISCV_RW_WRITER when a
+ * writer holds the lock. Readers do not exclude each other so it suits
+ * read-mostly state where writers are rare.
+ */
+typedef struct {
+	volatile long lock;
+} rwlock_t;
+
+#define __RISCV_RW_UNLOCKED 0
+#define __RISCV_RW_WRITER -1
+
+#define RW_LOCK_INIT(_lptr) (_lptr)->lock = __RISCV_RW_UNLOCKED
+
+#define RW_LOCK_INITIALIZER                  \
+	{                                    \
+		.lock = __RISCV_RW_UNLOCKED, \
+	}
+
+int read_trylock(rwlock_t *lock);
+
+void read_lock(rwlock_t *lock);
+
+void read_unlock(rwlock_t *lock);
+
+int write_trylock(rwlock_t *lock);
+
+void write_lock(rwlock_t *lock);
+
+void write_unlock(rwlock_t *lock);
+
+/*
+ * Sequence lock
+ *
+ * Writers serialize on a spinlock and make the sequence odd while
+ * updating. Readers never write to shared memory: they retry when the
+ * sequence was odd or changed while they were reading.
+ */
+typedef struct {
+	volatile unsigned long sequence;
+	spinlock_t lock;
+} seqlock_t;
+
+#define SEQ_LOCK_INIT(_lptr)                 \
+	do {                                 \
+		(_lptr)->sequence = 0;       \
+		SPIN_LOCK_INIT(&(_lptr)->lock); \
+	} while (0)
+
+#define SEQ_LOCK_NAMED_INITIALIZER(_name)               \
+	{                                               \
+		.sequence = 0,                          \
+		.lock = SPIN_LOCK_NAMED_INITIALIZER(_name), \
+	}
+
+#define SEQ_LOCK_INITIALIZER SEQ_LOCK_NAMED_INITIALIZER(NULL)
+
+void write_seqlock(seqlock_t *sl);
+
+void write_sequnlock(seqlock_t *sl);
+
+/**
+ * Start a lockless read section of a seqlock
+ * @sl: seqlock to read
+ *
+ * @return sequence to pass to read_seqretry()
+ */
+static inline unsigned long read_seqbegin(const seqlock_t *sl)
+{
+	unsigned long seq;
+
+	while ((seq = sl->sequence) & 1)
+		cpu_relax();
+	smp_rmb();
+
+	return seq;
+}
+
+/**
+ * End a lockless read section of a seqlock
+ * @sl: seqlock to read
+ * @start: sequence returned by read_seqbegin()
+ *
+ * @return non-zero if a writer interfered and the read must be retried
+ */
+static inline int read_seqretry(const seqlock_t *sl, unsigned long start)
+{
+	smp_rmb();
+
+	return (sl->sequence != start) ? 1 : 0;
+}
+
 #endif
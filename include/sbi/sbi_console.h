@@ -14,6 +14,19 @@
 
 #define __printf(a, b) __attribute__((format(printf, a, b)))
 
+/* clang-format off */
+
+/** Size of the per-HART console output ring (power of 2) */
+#define SBI_CONSOLE_RING_SIZE			256
+
+/** Timer ticks before a HART retries draining its console ring */
+#define SBI_CONSOLE_DRAIN_DELAY			1000
+
+/** Size of the console receive ring (power of 2) */
+#define SBI_CONSOLE_RX_RING_SIZE		256
+
+/* clang-format on */
+
 bool sbi_isprintable(char ch);
 
 int sbi_getc(void);
@@ -22,8 +35,26 @@ void sbi_putc(char ch);
 
 void sbi_puts(const char *str);
 
+/**
+ * Write a buffer to the console
+ * @param str the buffer, need not be NUL terminated
+ * @param len number of bytes to write
+ *
+ * @return number of bytes written
+ */
+ulong sbi_nputs(const char *str, ulong len);
+
 void sbi_gets(char *s, int maxwidth, char endchar);
 
+/**
+ * Read pending console input without waiting
+ * @param str destination buffer
+ * @param len size of the buffer
+ *
+ * @return number of bytes read
+ */
+ulong sbi_ngets(char *str, ulong len);
+
 int __printf(2, 3) sbi_sprintf(char *out, const char *format, ...);
 
 int __printf(3, 4) sbi_snprintf(char *out, u32 out_sz, const char *format, ...);
@@ -35,6 +66,46 @@ struct sbi_scratch;
 int __printf(2, 3) sbi_dprintf(struct sbi_scratch *scratch,
 			       const char *format, ...);
 
+/**
+ * Write all buffered console output, waiting for the transmitter
+ */
+void sbi_console_flush(void);
+
+/**
+ * Switch the console to synchronous output for error reporting
+ *
+ * Buffered output of every HART is written out first and later output
+ * bypasses the rings so nothing is lost if the firmware stops.
+ */
+void sbi_console_panic(void);
+
 int sbi_console_init(struct sbi_scratch *scratch);
 
+/**
+ * Start buffering console output of current HART
+ *
+ * Until called a HART writes its output synchronously. Requires the
+ * timer of current HART to be initialized.
+ */
+int sbi_console_ring_init(struct sbi_scratch *scratch, bool cold_boot);
+
+/**
+ * Move received console input into the receive ring
+ *
+ * Called for M-mode external interrupts of current HART.
+ *
+ * @return 0 on success and SBI_ENODEV if the pending interrupt does not
+ * belong to the console
+ */
+int sbi_console_irq_process(struct sbi_scratch *scratch);
+
+/**
+ * Serve console input from an interrupt driven receive ring
+ *
+ * Only done when built with SBI_CONSOLE_RX_IRQ because the console
+ * then consumes input of a UART the OS might drive itself. The cold
+ * boot HART takes the receive interrupt, every HART reads the ring.
+ */
+int sbi_console_irq_init(struct sbi_scratch *scratch, bool cold_boot);
+
 #endif
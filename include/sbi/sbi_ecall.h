@@ -12,13 +12,62 @@
 
 #include <sbi/sbi_types.h>
 
+/* clang-format off */
+
+/** Maximum number of registered SBI extensions (or extension ranges) */
+#define SBI_ECALL_MAX_EXTENSIONS	16
+
+/* clang-format on */
+
 struct sbi_trap_regs;
+struct sbi_trap_info;
 struct sbi_scratch;
 
+/** Values returned by an SBI extension handler besides its error code */
+struct sbi_ecall_return {
+	/** Value returned in a1 along with the error code in a0 */
+	unsigned long value;
+	/** Handler wrote a0/a1 itself so only mepc is advanced */
+	bool regs_updated;
+};
+
+/** Representation of an SBI extension (or range of extension IDs) */
+struct sbi_ecall_extension {
+	/** First extension ID handled */
+	unsigned long extid_start;
+	/** Last extension ID handled */
+	unsigned long extid_end;
+	/** Probe availability (optional, available when NULL) */
+	int (*probe)(struct sbi_scratch *scratch, unsigned long extid,
+		     unsigned long *out_val);
+	/** Handle a call and return an SBI error code */
+	int (*handle)(struct sbi_scratch *scratch, unsigned long extid,
+		      unsigned long funcid, struct sbi_trap_regs *regs,
+		      struct sbi_ecall_return *out,
+		      struct sbi_trap_info *out_trap);
+};
+
 u16 sbi_ecall_version_major(void);
 
 u16 sbi_ecall_version_minor(void);
 
+struct sbi_ecall_extension *sbi_ecall_find_extension(unsigned long extid);
+
+/**
+ * Register an SBI extension
+ *
+ * Must be called on the cold boot HART before other HARTs are released,
+ * for example from the platform early_init or final_init callbacks.
+ * Extension ID ranges must not overlap with registered ones.
+ *
+ * @param ext pointer to extension descriptor (must stay valid)
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_ecall_register_extension(struct sbi_ecall_extension *ext);
+
+int sbi_ecall_init(struct sbi_scratch *scratch);
+
 int sbi_ecall_handler(u32 hartid, ulong mcause, struct sbi_trap_regs *regs,
 		      struct sbi_scratch *scratch);
 
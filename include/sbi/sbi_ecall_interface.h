@@ -23,6 +23,11 @@ enum sbi_ext_id {
 	SBI_EXT_0_1_REMOTE_SFENCE_VMA_ASID = 0x7,
 	SBI_EXT_0_1_SHUTDOWN = 0x8,
 	SBI_EXT_BASE = 0x10,
+	SBI_EXT_TIME = 0x54494D45,
+	SBI_EXT_IPI = 0x735049,
+	SBI_EXT_RFENCE = 0x52464E43,
+	SBI_EXT_DBCN = 0x4442434E,
+	SBI_EXT_FW_DEBUG = 0x0A000000,
 };
 
 enum sbi_ext_base_fid {
@@ -35,12 +40,95 @@ enum sbi_ext_base_fid {
 	SBI_EXT_BASE_GET_MIMPID,
 };
 
+enum sbi_ext_time_fid {
+	SBI_EXT_TIME_SET_TIMER = 0,
+};
+
+enum sbi_ext_ipi_fid {
+	SBI_EXT_IPI_SEND_IPI = 0,
+};
+
+/*
+ * All range based RFENCE functions accept an optional stride hint in a5
+ * (non-standard): the leaf page size mapping the range (4KB, 2MB or 1GB,
+ * 4KB or 4MB on RV32), zero or any other value selects 4KB.
+ */
+enum sbi_ext_rfence_fid {
+	SBI_EXT_RFENCE_REMOTE_FENCE_I = 0,
+	SBI_EXT_RFENCE_REMOTE_SFENCE_VMA,
+	SBI_EXT_RFENCE_REMOTE_SFENCE_VMA_ASID,
+	SBI_EXT_RFENCE_REMOTE_HFENCE_GVMA_VMID,
+	SBI_EXT_RFENCE_REMOTE_HFENCE_GVMA,
+	SBI_EXT_RFENCE_REMOTE_HFENCE_VVMA_ASID,
+	SBI_EXT_RFENCE_REMOTE_HFENCE_VVMA,
+};
+
+/*
+ * Debug console extension, buffers are given as physical address split
+ * in low (a1) and high (a2) halves with the length in a0
+ */
+enum sbi_ext_dbcn_fid {
+	SBI_EXT_DBCN_CONSOLE_WRITE = 0,
+	SBI_EXT_DBCN_CONSOLE_READ,
+	SBI_EXT_DBCN_CONSOLE_WRITE_BYTE,
+};
+
+/*
+ * Firmware debug extension (firmware specific extension space). The
+ * lock statistics functions return SBI_ERR_NOT_SUPPORTED unless the
+ * firmware was built with SBI_LOCK_STATS=y. Trap statistics count the
+ * traps handled per HART and cause along with the mcycle spent in
+ * M-mode handling them. The binary log functions print all records
+ * (LOG_DRAIN), copy whole struct sbi_log_record entries of HART a0 to
+ * the physical buffer at a1 of a2 bytes (LOG_READ) or count the records
+ * HART a0 dropped (LOG_DROPPED).
+ */
+enum sbi_ext_fw_debug_fid {
+	SBI_EXT_FW_DEBUG_LOCK_STATS_COUNT = 0,
+	SBI_EXT_FW_DEBUG_LOCK_STATS_READ,
+	SBI_EXT_FW_DEBUG_LOCK_STATS_RESET,
+	SBI_EXT_FW_DEBUG_LOCK_STATS_DUMP,
+	SBI_EXT_FW_DEBUG_TRAP_STATS_COUNT,
+	SBI_EXT_FW_DEBUG_TRAP_STATS_CYCLES,
+	SBI_EXT_FW_DEBUG_TRAP_STATS_RESET,
+	SBI_EXT_FW_DEBUG_LOG_DRAIN,
+	SBI_EXT_FW_DEBUG_LOG_READ,
+	SBI_EXT_FW_DEBUG_LOG_DROPPED,
+};
+
+/* Counters selected by a1 of SBI_EXT_FW_DEBUG_LOCK_STATS_READ */
+enum sbi_fw_debug_lock_stat {
+	SBI_FW_DEBUG_LOCK_STAT_ACQUIRED = 0,
+	SBI_FW_DEBUG_LOCK_STAT_CONTENDED,
+	SBI_FW_DEBUG_LOCK_STAT_SPINS,
+	SBI_FW_DEBUG_LOCK_STAT_MAX_HOLD,
+};
+
+/*
+ * Trap causes selected by a1 of SBI_EXT_FW_DEBUG_TRAP_STATS_COUNT and
+ * SBI_EXT_FW_DEBUG_TRAP_STATS_CYCLES, a0 selects the HART
+ */
+enum sbi_fw_debug_trap_stat {
+	SBI_FW_DEBUG_TRAP_STAT_TIMER_IRQ = 0,
+	SBI_FW_DEBUG_TRAP_STAT_SOFT_IRQ,
+	SBI_FW_DEBUG_TRAP_STAT_ECALL,
+	SBI_FW_DEBUG_TRAP_STAT_ILLEGAL_INSN,
+	SBI_FW_DEBUG_TRAP_STAT_MISALIGNED_LOAD,
+	SBI_FW_DEBUG_TRAP_STAT_MISALIGNED_STORE,
+	SBI_FW_DEBUG_TRAP_STAT_ACCESS_FAULT,
+	SBI_FW_DEBUG_TRAP_STAT_REDIRECT,
+	SBI_FW_DEBUG_TRAP_STAT_EXT_IRQ,
+	SBI_FW_DEBUG_TRAP_STAT_MAX,
+};
+
 #define SBI_SPEC_VERSION_MAJOR_OFFSET	24
 #define SBI_SPEC_VERSION_MAJOR_MASK	0x7f
 #define SBI_SPEC_VERSION_MINOR_MASK	0xffffff
 #define SBI_KEYSTONE_SM 		0x08000000
 #define SBI_EXT_VENDOR_START		0x09000000
 #define SBI_EXT_VENDOR_END		0x09FFFFFF
+#define SBI_EXT_FIRMWARE_START		0x0A000000
+#define SBI_EXT_FIRMWARE_END		0x0AFFFFFF
 /* clang-format on */
 
 #endif
@@ -12,6 +12,7 @@
 #define __SBI_FIFO_H__
 
 #include <sbi/riscv_locks.h>
+#include <sbi/sbi_bits.h>
 #include <sbi/sbi_types.h>
 
 struct sbi_fifo {
@@ -21,8 +22,26 @@ struct sbi_fifo {
 	u16 num_entries;
 	u16 avail;
 	u16 tail;
+	u16 flags;
+	u16 slot_size;
+	/* Below members are only used by lock-free MPSC fifo */
+	volatile unsigned long prod_pos;
+	volatile unsigned long cons_pos;
 };
 
+enum sbi_fifo_flags {
+	/** Lock-free multi-producer single-consumer fifo */
+	SBI_FIFO_MPSC = (1 << 0),
+};
+
+/** Size of one lock-free MPSC fifo slot (sequence number + entry) */
+#define SBI_FIFO_MPSC_SLOT_SIZE(__entry_size) \
+	(__SIZEOF_POINTER__ + ROUNDUP(__entry_size, __SIZEOF_POINTER__))
+
+/** Size of queue memory required by a lock-free MPSC fifo */
+#define SBI_FIFO_MPSC_MEM_SIZE(__entries, __entry_size) \
+	((__entries) * SBI_FIFO_MPSC_SLOT_SIZE(__entry_size))
+
 enum sbi_fifo_inplace_update_types {
 	SBI_FIFO_SKIP,
 	SBI_FIFO_UPDATED,
@@ -33,6 +52,8 @@ int sbi_fifo_dequeue(struct sbi_fifo *fifo, void *data);
 int sbi_fifo_enqueue(struct sbi_fifo *fifo, void *data);
 void sbi_fifo_init(struct sbi_fifo *fifo, void *queue_mem, u16 entries,
 		   u16 entry_size);
+int sbi_fifo_init_mpsc(struct sbi_fifo *fifo, void *queue_mem, u16 entries,
+		       u16 entry_size);
 bool sbi_fifo_is_empty(struct sbi_fifo *fifo);
 bool sbi_fifo_is_full(struct sbi_fifo *fifo);
 int sbi_fifo_inplace_update(struct sbi_fifo *fifo, void *in,
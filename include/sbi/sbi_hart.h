@@ -12,6 +12,7 @@
 
 #include <sbi/sbi_types.h>
 
+struct sbi_hartmask;
 struct sbi_scratch;
 
 int sbi_hart_init(struct sbi_scratch *scratch, u32 hartid, bool cold_boot);
@@ -31,7 +32,7 @@ sbi_hart_switch_mode(unsigned long arg0, unsigned long arg1,
 
 void sbi_hart_mark_available(u32 hartid);
 
-ulong sbi_hart_available_mask(void);
+void sbi_hart_available_mask(struct sbi_hartmask *mask);
 
 void sbi_hart_unmark_available(u32 hartid);
 
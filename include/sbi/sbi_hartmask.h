@@ -0,0 +1,223 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2019 Western Digital Corporation or its affiliates.
+ *
+ * Authors:
+ *   Anup Patel <anup.patel@wdc.com>
+ */
+
+#ifndef __SBI_HARTMASK_H__
+#define __SBI_HARTMASK_H__
+
+#include <sbi/sbi_bitops.h>
+#include <sbi/sbi_types.h>
+
+/* clang-format off */
+
+/**
+ * Maximum number of bits in a hartmask
+ *
+ * The hartmask is indexed using physical HART id so this define
+ * also represents the maximum HART id firmware can support.
+ */
+#ifndef SBI_HARTMASK_MAX_BITS
+#define SBI_HARTMASK_MAX_BITS		128
+#endif
+
+/** Number of words in a hartmask */
+#define SBI_HARTMASK_WORDS		\
+	((SBI_HARTMASK_MAX_BITS + BITS_PER_LONG - 1) / BITS_PER_LONG)
+
+/* clang-format on */
+
+/** Representation of hartmask */
+struct sbi_hartmask {
+	unsigned long bits[SBI_HARTMASK_WORDS];
+};
+
+/** Initialize hartmask to zero */
+#define SBI_HARTMASK_INIT(__m)	sbi_hartmask_clear_all(__m)
+
+/** Initialize hartmask to zero except a particular HART id */
+#define SBI_HARTMASK_INIT_EXCEPT(__m, __h)	\
+	do {					\
+		sbi_hartmask_clear_all(__m);	\
+		sbi_hartmask_set_hart(__h, __m);	\
+	} while (0)
+
+/**
+ * Get underlying bitmap of hartmask
+ * @param m the hartmask pointer
+ */
+#define sbi_hartmask_bits(__m)	((__m)->bits)
+
+/**
+ * Clear all HARTs in a hartmask
+ * @param m the hartmask pointer
+ */
+static inline void sbi_hartmask_clear_all(struct sbi_hartmask *m)
+{
+	u32 i;
+
+	for (i = 0; i < SBI_HARTMASK_WORDS; i++)
+		m->bits[i] = 0;
+}
+
+/**
+ * Set a HART in hartmask
+ * @param h HART id to set
+ * @param m the hartmask pointer
+ */
+static inline void sbi_hartmask_set_hart(u32 h, struct sbi_hartmask *m)
+{
+	if (h < SBI_HARTMASK_MAX_BITS)
+		m->bits[BIT_WORD(h)] |= BIT_MASK(h);
+}
+
+/**
+ * Clear a HART in hartmask
+ * @param h HART id to clear
+ * @param m the hartmask pointer
+ */
+static inline void sbi_hartmask_clear_hart(u32 h, struct sbi_hartmask *m)
+{
+	if (h < SBI_HARTMASK_MAX_BITS)
+		m->bits[BIT_WORD(h)] &= ~BIT_MASK(h);
+}
+
+/**
+ * Test a HART in hartmask
+ * @param h HART id to test
+ * @param m the hartmask pointer
+ *
+ * @return TRUE if HART is set and FALSE otherwise
+ */
+static inline bool sbi_hartmask_test_hart(u32 h,
+					  const struct sbi_hartmask *m)
+{
+	if (h < SBI_HARTMASK_MAX_BITS)
+		return (m->bits[BIT_WORD(h)] & BIT_MASK(h)) ? TRUE : FALSE;
+	return FALSE;
+}
+
+/**
+ * Check whether a hartmask is empty
+ * @param m the hartmask pointer
+ */
+static inline bool sbi_hartmask_empty(const struct sbi_hartmask *m)
+{
+	u32 i;
+
+	for (i = 0; i < SBI_HARTMASK_WORDS; i++)
+		if (m->bits[i])
+			return FALSE;
+	return TRUE;
+}
+
+/**
+ * Copy a hartmask
+ * @param dstp the destination hartmask pointer
+ * @param srcp the source hartmask pointer
+ */
+static inline void sbi_hartmask_copy(struct sbi_hartmask *dstp,
+				     const struct sbi_hartmask *srcp)
+{
+	u32 i;
+
+	for (i = 0; i < SBI_HARTMASK_WORDS; i++)
+		dstp->bits[i] = srcp->bits[i];
+}
+
+/**
+ * dstp = src1p & src2p
+ * @param dstp the hartmask result
+ * @param src1p the first input
+ * @param src2p the second input
+ */
+static inline void sbi_hartmask_and(struct sbi_hartmask *dstp,
+				    const struct sbi_hartmask *src1p,
+				    const struct sbi_hartmask *src2p)
+{
+	u32 i;
+
+	for (i = 0; i < SBI_HARTMASK_WORDS; i++)
+		dstp->bits[i] = src1p->bits[i] & src2p->bits[i];
+}
+
+/**
+ * dstp = src1p | src2p
+ * @param dstp the hartmask result
+ * @param src1p the first input
+ * @param src2p the second input
+ */
+static inline void sbi_hartmask_or(struct sbi_hartmask *dstp,
+				   const struct sbi_hartmask *src1p,
+				   const struct sbi_hartmask *src2p)
+{
+	u32 i;
+
+	for (i = 0; i < SBI_HARTMASK_WORDS; i++)
+		dstp->bits[i] = src1p->bits[i] | src2p->bits[i];
+}
+
+/**
+ * Set HARTs (base + N) for every bit N set in an XLEN wide mask as
+ * passed by the SBI v0.2 hart_mask and hart_mask_base parameters
+ * @param mask the XLEN wide mask
+ * @param base HART id of bit 0 in mask
+ * @param m the hartmask pointer
+ */
+static inline void sbi_hartmask_set_ulong(ulong mask, ulong base,
+					  struct sbi_hartmask *m)
+{
+	ulong word, shift;
+
+	if (base >= SBI_HARTMASK_MAX_BITS)
+		return;
+
+	word  = BIT_WORD(base);
+	shift = base % BITS_PER_LONG;
+	m->bits[word] |= mask << shift;
+	if (shift && (word + 1) < SBI_HARTMASK_WORDS)
+		m->bits[word + 1] |= mask >> (BITS_PER_LONG - shift);
+}
+
+/**
+ * Find next HART set in hartmask starting from (and including) a HART
+ * @param m the hartmask pointer
+ * @param h HART id to start searching from
+ *
+ * @return next HART id set or SBI_HARTMASK_MAX_BITS if none
+ */
+static inline u32 sbi_hartmask_next_hart(const struct sbi_hartmask *m, u32 h)
+{
+	u32 i;
+	unsigned long word;
+
+	if (h >= SBI_HARTMASK_MAX_BITS)
+		return SBI_HARTMASK_MAX_BITS;
+
+	i = BIT_WORD(h);
+	word = m->bits[i] & (~0UL << (h % BITS_PER_LONG));
+	while (!word) {
+		if (++i >= SBI_HARTMASK_WORDS)
+			return SBI_HARTMASK_MAX_BITS;
+		word = m->bits[i];
+	}
+
+	h = i * BITS_PER_LONG + __ffs(word);
+	return (h < SBI_HARTMASK_MAX_BITS) ? h : SBI_HARTMASK_MAX_BITS;
+}
+
+/**
+ * Iterate over each HART set in hartmask, skipping empty words
+ * @param __h the HART id (u32) used as loop cursor
+ * @param __m the hartmask pointer
+ */
+#define sbi_hartmask_for_each_hart(__h, __m)			\
+	for ((__h) = sbi_hartmask_next_hart((__m), 0);		\
+	     (__h) < SBI_HARTMASK_MAX_BITS;			\
+	     (__h) = sbi_hartmask_next_hart((__m), (__h) + 1))
+
+#endif
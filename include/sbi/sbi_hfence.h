@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2019 Western Digital Corporation or its affiliates.
+ *
+ * Authors:
+ *   Atish Patra <atish.patra@wdc.com>
+ *   Anup Patel <anup.patel@wdc.com>
+ */
+
+#ifndef __SBI_HFENCE_H__
+#define __SBI_HFENCE_H__
+
+/** Invalidate G-stage TLB entries of a guest physical address (>> 2) and VMID */
+void __sbi_hfence_gvma_vmid_gpa(unsigned long gpa_divby_4,
+				unsigned long vmid);
+/** Invalidate all G-stage TLB entries of a VMID */
+void __sbi_hfence_gvma_vmid(unsigned long vmid);
+/** Invalidate G-stage TLB entries of a guest physical address (>> 2) */
+void __sbi_hfence_gvma_gpa(unsigned long gpa_divby_4);
+/** Invalidate all G-stage TLB entries */
+void __sbi_hfence_gvma_all(void);
+
+/** Invalidate VS-stage TLB entries of a guest virtual address and ASID */
+void __sbi_hfence_vvma_asid_va(unsigned long va, unsigned long asid);
+/** Invalidate all VS-stage TLB entries of an ASID */
+void __sbi_hfence_vvma_asid(unsigned long asid);
+/** Invalidate VS-stage TLB entries of a guest virtual address */
+void __sbi_hfence_vvma_va(unsigned long va);
+/** Invalidate all VS-stage TLB entries */
+void __sbi_hfence_vvma_all(void);
+
+#endif
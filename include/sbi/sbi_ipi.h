@@ -23,15 +23,13 @@
 /* clang-format on */
 
 struct sbi_scratch;
-struct sbi_trap_info;
 
 struct sbi_ipi_data {
 	unsigned long ipi_type;
 };
 
-int sbi_ipi_send_many(struct sbi_scratch *scratch,
-		      struct sbi_trap_info *uptrap,
-		      ulong *pmask, u32 event, void *data);
+int sbi_ipi_send_many(struct sbi_scratch *scratch, ulong hmask, ulong hbase,
+		      u32 event, void *data);
 
 void sbi_ipi_clear_smode(struct sbi_scratch *scratch);
 
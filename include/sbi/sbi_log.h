@@ -0,0 +1,195 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2019 Western Digital Corporation or its affiliates.
+ */
+
+#ifndef __SBI_LOG_H__
+#define __SBI_LOG_H__
+
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_types.h>
+
+/*
+ * Compile-time log levels
+ *
+ * Messages above the level of their subsystem are discarded by the
+ * compiler, so disabled tracing costs neither code nor console time.
+ * A source file selects its subsystem by defining SBI_LOG_SUBSYS before
+ * including this header. The global level comes from SBI_LOG_LEVEL and
+ * each subsystem can override it with SBI_LOG_LEVEL_<subsystem>.
+ */
+
+/* clang-format off */
+
+#define SBI_LOG_NONE				0
+#define SBI_LOG_ERR				1
+#define SBI_LOG_WARN				2
+#define SBI_LOG_INFO				3
+#define SBI_LOG_DEBUG				4
+
+#ifndef SBI_LOG_LEVEL
+#define SBI_LOG_LEVEL				SBI_LOG_INFO
+#endif
+
+#ifndef SBI_LOG_LEVEL_GENERIC
+#define SBI_LOG_LEVEL_GENERIC			SBI_LOG_LEVEL
+#endif
+#ifndef SBI_LOG_LEVEL_INIT
+#define SBI_LOG_LEVEL_INIT			SBI_LOG_LEVEL
+#endif
+#ifndef SBI_LOG_LEVEL_HART
+#define SBI_LOG_LEVEL_HART			SBI_LOG_LEVEL
+#endif
+#ifndef SBI_LOG_LEVEL_TIMER
+#define SBI_LOG_LEVEL_TIMER			SBI_LOG_LEVEL
+#endif
+#ifndef SBI_LOG_LEVEL_CLINT
+#define SBI_LOG_LEVEL_CLINT			SBI_LOG_LEVEL
+#endif
+#ifndef SBI_LOG_LEVEL_PLATFORM
+#define SBI_LOG_LEVEL_PLATFORM			SBI_LOG_LEVEL
+#endif
+
+#ifndef SBI_LOG_SUBSYS
+#define SBI_LOG_SUBSYS				GENERIC
+#endif
+
+/* clang-format on */
+
+#define __SBI_LOG_LEVEL_OF(__s)		SBI_LOG_LEVEL_##__s
+#define __SBI_LOG_LEVEL(__s)		__SBI_LOG_LEVEL_OF(__s)
+
+/** Check at compile time whether messages of a level are enabled */
+#define sbi_log_enabled(__lvl)	(__SBI_LOG_LEVEL(SBI_LOG_SUBSYS) >= (__lvl))
+
+/*
+ * The arguments stay visible to the compiler so disabled messages are
+ * still type checked but no code is emitted for them.
+ */
+#define sbi_log(__lvl, __fmt, ...)				\
+	do {							\
+		if (sbi_log_enabled(__lvl))			\
+			sbi_printf(__fmt, ##__VA_ARGS__);	\
+	} while (0)
+
+#define sbi_log_err(__fmt, ...)	sbi_log(SBI_LOG_ERR, __fmt, ##__VA_ARGS__)
+#define sbi_log_warn(__fmt, ...) sbi_log(SBI_LOG_WARN, __fmt, ##__VA_ARGS__)
+#define sbi_log_info(__fmt, ...) sbi_log(SBI_LOG_INFO, __fmt, ##__VA_ARGS__)
+#define sbi_log_debug(__fmt, ...) sbi_log(SBI_LOG_DEBUG, __fmt, ##__VA_ARGS__)
+
+/*
+ * Binary log
+ *
+ * sbi_log_bin() stores the format pointer, a timestamp, the HART id and
+ * up to SBI_LOG_RECORD_ARGS arguments in a per-HART ring instead of
+ * printing. Recording costs a few stores, so it can stay enabled on the
+ * runtime path. Records are formatted later by sbi_log_bin_drain() or
+ * copied raw to S-mode through the firmware debug extension, in which
+ * case the format pointer is resolved against the firmware image.
+ *
+ * The format must be a string literal. Arguments are stored as unsigned
+ * long so 64-bit values need two arguments on RV32. Records are dropped
+ * (and counted) while the ring of a HART is full.
+ */
+
+/* clang-format off */
+
+#define SBI_LOG_RECORD_ARGS			4
+/** Number of records in the binary log ring of each HART (power of 2) */
+#define SBI_LOG_RING_ENTRIES			16
+
+/* clang-format on */
+
+/** Binary log record, also the layout copied to S-mode */
+struct sbi_log_record {
+	/** Format string in the firmware image */
+	const char *fmt;
+	/** Timer value when the record was made */
+	u64 time;
+	/** HART which made the record */
+	u32 hartid;
+	/** Number of valid entries in args */
+	u32 nargs;
+	unsigned long args[SBI_LOG_RECORD_ARGS];
+};
+
+struct sbi_scratch;
+struct sbi_trap_info;
+
+void sbi_log_bin_record(const char *fmt, u32 nargs, unsigned long a0,
+			unsigned long a1, unsigned long a2, unsigned long a3);
+
+#define __sbi_log_bin0(__f)						\
+	sbi_log_bin_record(__f, 0, 0, 0, 0, 0)
+#define __sbi_log_bin1(__f, __a0)					\
+	sbi_log_bin_record(__f, 1, (unsigned long)(__a0), 0, 0, 0)
+#define __sbi_log_bin2(__f, __a0, __a1)					\
+	sbi_log_bin_record(__f, 2, (unsigned long)(__a0),		\
+			   (unsigned long)(__a1), 0, 0)
+#define __sbi_log_bin3(__f, __a0, __a1, __a2)				\
+	sbi_log_bin_record(__f, 3, (unsigned long)(__a0),		\
+			   (unsigned long)(__a1), (unsigned long)(__a2), 0)
+#define __sbi_log_bin4(__f, __a0, __a1, __a2, __a3)			\
+	sbi_log_bin_record(__f, 4, (unsigned long)(__a0),		\
+			   (unsigned long)(__a1), (unsigned long)(__a2),	\
+			   (unsigned long)(__a3))
+
+#define __SBI_LOG_BIN_SEL(_0, _1, _2, _3, _4, __n, ...)	__n
+
+/*
+ * Levels are filtered at compile time like sbi_log(). The dead
+ * sbi_printf() call only lets the compiler check the arguments.
+ */
+#define sbi_log_bin(__lvl, __fmt, ...)					\
+	do {								\
+		if (sbi_log_enabled(__lvl))				\
+			__SBI_LOG_BIN_SEL(0, ##__VA_ARGS__,		\
+					  __sbi_log_bin4,		\
+					  __sbi_log_bin3,		\
+					  __sbi_log_bin2,		\
+					  __sbi_log_bin1,		\
+					  __sbi_log_bin0)		\
+				(__fmt, ##__VA_ARGS__);			\
+		if (0)							\
+			sbi_printf(__fmt, ##__VA_ARGS__);		\
+	} while (0)
+
+/**
+ * Format and print the binary log records of all HARTs
+ */
+void sbi_log_bin_drain(void);
+
+/**
+ * Print the binary log records of all HARTs from an error path
+ *
+ * Skipped if another HART is reading the records so a fault taken
+ * while reading cannot deadlock the error report.
+ */
+void sbi_log_bin_panic(void);
+
+/**
+ * Copy binary log records of a HART to a physical address
+ *
+ * Only whole records are copied and they are removed from the ring.
+ *
+ * @param scratch pointer to sbi_scratch of current HART
+ * @param hartid HART whose records are read
+ * @param addr destination physical address
+ * @param len size of the destination in bytes
+ * @param out number of bytes copied
+ * @param trap trap details when the destination faults
+ *
+ * @return 0 on success and negative error code on failure
+ */
+int sbi_log_bin_read(struct sbi_scratch *scratch, u32 hartid, ulong addr,
+		     ulong len, ulong *out, struct sbi_trap_info *trap);
+
+/**
+ * Get the number of binary log records a HART dropped so far
+ */
+u32 sbi_log_bin_dropped(struct sbi_scratch *scratch, u32 hartid);
+
+int sbi_log_bin_init(struct sbi_scratch *scratch, bool cold_boot);
+
+#endif
@@ -43,6 +43,7 @@
 
 #include <sbi/sbi_ecall.h>
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_trap.h>
 #include <sbi/sbi_version.h>
@@ -97,16 +98,40 @@ struct sbi_platform_operations {
 
 	/** Write a character to the platform console output */
 	void (*console_putc)(char ch);
+	/**
+	 * Write a character to the platform console output without
+	 * waiting, returns -1 if the transmitter has no room
+	 */
+	int (*console_try_putc)(char ch);
+	/**
+	 * Write up to len characters to the platform console output
+	 * without waiting, returns the number of characters written
+	 */
+	int (*console_puts)(const char *str, size_t len);
 	/** Read a character from the platform console input */
 	int (*console_getc)(void);
 	/** Initialize the platform console */
 	int (*console_init)(void);
+	/**
+	 * Route the console receive interrupt to M-mode of current HART,
+	 * returns the interrupt source number
+	 */
+	int (*console_irq_init)(void);
 
 	/** Initialize the platform interrupt controller for current HART */
 	int (*irqchip_init)(bool cold_boot);
+	/** Claim the pending M-mode external interrupt of current HART */
+	u32 (*irqchip_claim)(void);
+	/** Complete a claimed M-mode external interrupt of current HART */
+	void (*irqchip_complete)(u32 source);
 
 	/** Send IPI to a target HART */
 	void (*ipi_send)(u32 target_hart);
+	/**
+	 * Send IPI to a set of target HARTs where bit N of mask
+	 * represents HART ID (base + N)
+	 */
+	void (*ipi_send_mask)(ulong mask, ulong base);
 	/** Clear IPI for a target HART */
 	void (*ipi_clear)(u32 target_hart);
 	/** Initialize IPI for current HART */
@@ -159,7 +184,10 @@ struct sbi_platform {
 	u32 hart_stack_size;
 	/** Mask representing the set of disabled HARTs */
 	u64 disabled_hart_mask;
-	/* Maximum value of tlb flush range request*/
+	/**
+	 * Maximum value of tlb flush range request. Zero means calibrate
+	 * at boot time using mcycle.
+	 */
 	u64 tlb_range_flush_limit;
 	/** Pointer to sbi platform operations */
 	unsigned long platform_ops_addr;
@@ -220,7 +248,8 @@ static inline const char *sbi_platform_name(const struct sbi_platform *plat)
 static inline bool sbi_platform_hart_disabled(const struct sbi_platform *plat,
 					      u32 hartid)
 {
-	if (plat && (plat->disabled_hart_mask & (1 << hartid)))
+	if (plat && (hartid < 64) &&
+	    (plat->disabled_hart_mask & (1ULL << hartid)))
 		return TRUE;
 	return FALSE;
 }
@@ -231,14 +260,14 @@ static inline bool sbi_platform_hart_disabled(const struct sbi_platform *plat,
  *
  * @param plat pointer to struct sbi_platform
  *
- * @return tlb range flush limit value. Returns a default (page size) if not
- * defined by platform.
+ * @return tlb range flush limit value. Returns 0 if not defined by platform
+ * in which case the limit is calibrated at boot time.
  */
 static inline u64 sbi_platform_tlbr_flush_limit(const struct sbi_platform *plat)
 {
-	if (plat && plat->tlb_range_flush_limit)
+	if (plat)
 		return plat->tlb_range_flush_limit;
-	return SBI_PLATFORM_TLB_RANGE_FLUSH_LIMIT_DEFAULT;
+	return 0;
 }
 
 /**
@@ -384,6 +413,54 @@ static inline void sbi_platform_console_putc(const struct sbi_platform *plat,
 		sbi_platform_ops(plat)->console_putc(ch);
 }
 
+/**
+ * Write a character to the platform console output without waiting
+ *
+ * Platforms without a non-blocking console fall back to
+ * sbi_platform_console_putc(), which may wait for the transmitter.
+ *
+ * @param plat pointer to struct sbi_platform
+ * @param ch character to write
+ *
+ * @return 0 if the character was written and -1 if the transmitter
+ * has no room for it
+ */
+static inline int sbi_platform_console_try_putc(const struct sbi_platform *plat,
+						char ch)
+{
+	if (plat && sbi_platform_ops(plat)->console_try_putc)
+		return sbi_platform_ops(plat)->console_try_putc(ch);
+	sbi_platform_console_putc(plat, ch);
+	return 0;
+}
+
+/**
+ * Write characters to the platform console output without waiting
+ *
+ * Platforms without a burst write fall back to
+ * sbi_platform_console_try_putc() for each character.
+ *
+ * @param plat pointer to struct sbi_platform
+ * @param str characters to write
+ * @param len number of characters
+ *
+ * @return number of characters written, zero if the transmitter is full
+ */
+static inline int sbi_platform_console_puts(const struct sbi_platform *plat,
+					    const char *str, size_t len)
+{
+	size_t i;
+
+	if (plat && sbi_platform_ops(plat)->console_puts)
+		return sbi_platform_ops(plat)->console_puts(str, len);
+
+	for (i = 0; i < len; i++)
+		if (sbi_platform_console_try_putc(plat, str[i]))
+			break;
+
+	return i;
+}
+
 /**
  * Read a character from the platform console input
  *
@@ -412,6 +489,21 @@ static inline int sbi_platform_console_init(const struct sbi_platform *plat)
 	return 0;
 }
 
+/**
+ * Route the platform console receive interrupt to M-mode of current HART
+ *
+ * @param plat pointer to struct sbi_platform
+ *
+ * @return interrupt source number, zero or SBI_ENOTSUPP if the console
+ * has no usable receive interrupt and negative error code on failure
+ */
+static inline int sbi_platform_console_irq_init(const struct sbi_platform *plat)
+{
+	if (plat && sbi_platform_ops(plat)->console_irq_init)
+		return sbi_platform_ops(plat)->console_irq_init();
+	return 0;
+}
+
 /**
  * Initialize the platform interrupt controller for current HART
  *
@@ -428,6 +520,33 @@ static inline int sbi_platform_irqchip_init(const struct sbi_platform *plat,
 	return 0;
 }
 
+/**
+ * Claim the pending M-mode external interrupt of current HART
+ *
+ * @param plat pointer to struct sbi_platform
+ *
+ * @return interrupt source number or zero if none is pending
+ */
+static inline u32 sbi_platform_irqchip_claim(const struct sbi_platform *plat)
+{
+	if (plat && sbi_platform_ops(plat)->irqchip_claim)
+		return sbi_platform_ops(plat)->irqchip_claim();
+	return 0;
+}
+
+/**
+ * Complete a claimed M-mode external interrupt of current HART
+ *
+ * @param plat pointer to struct sbi_platform
+ * @param source interrupt source number returned by the claim
+ */
+static inline void sbi_platform_irqchip_complete(const struct sbi_platform *plat,
+						 u32 source)
+{
+	if (plat && sbi_platform_ops(plat)->irqchip_complete)
+		sbi_platform_ops(plat)->irqchip_complete(source);
+}
+
 /**
  * Send IPI to a target HART
  *
@@ -441,6 +560,54 @@ static inline void sbi_platform_ipi_send(const struct sbi_platform *plat,
 		sbi_platform_ops(plat)->ipi_send(target_hart);
 }
 
+/**
+ * Send IPI to a set of target HARTs
+ *
+ * Falls back to sending IPI one HART at a time if the platform
+ * does not provide a batched operation.
+ *
+ * @param plat pointer to struct sbi_platform
+ * @param mask mask of target HARTs where bit N is HART ID (base + N)
+ * @param base HART ID of the first bit in mask
+ */
+static inline void sbi_platform_ipi_send_mask(const struct sbi_platform *plat,
+					      ulong mask, ulong base)
+{
+	ulong i;
+
+	if (!plat)
+		return;
+
+	if (sbi_platform_ops(plat)->ipi_send_mask) {
+		sbi_platform_ops(plat)->ipi_send_mask(mask, base);
+		return;
+	}
+
+	if (!sbi_platform_ops(plat)->ipi_send)
+		return;
+	for (i = 0; mask; i++, mask >>= 1)
+		if (mask & 1UL)
+			sbi_platform_ops(plat)->ipi_send(base + i);
+}
+
+/**
+ * Send IPI to all HARTs set in a hartmask
+ *
+ * @param plat pointer to struct sbi_platform
+ * @param mask pointer to the hartmask of target HARTs
+ */
+static inline void sbi_platform_ipi_send_hartmask(
+					const struct sbi_platform *plat,
+					const struct sbi_hartmask *mask)
+{
+	u32 i;
+
+	for (i = 0; i < SBI_HARTMASK_WORDS; i++)
+		if (mask->bits[i])
+			sbi_platform_ipi_send_mask(plat, mask->bits[i],
+						   i * BITS_PER_LONG);
+}
+
 /**
  * Clear IPI for a target HART
  *
@@ -34,10 +34,21 @@
 #define SBI_SCRATCH_TMP0_OFFSET			(8 * __SIZEOF_POINTER__)
 /** Offset of options member in sbi_scratch */
 #define SBI_SCRATCH_OPTIONS_OFFSET		(9 * __SIZEOF_POINTER__)
+/** Offset of tmp1 member in sbi_scratch */
+#define SBI_SCRATCH_TMP1_OFFSET			(10 * __SIZEOF_POINTER__)
 /** Offset of extra space in sbi_scratch */
-#define SBI_SCRATCH_EXTRA_SPACE_OFFSET		(10 * __SIZEOF_POINTER__)
+#define SBI_SCRATCH_EXTRA_SPACE_OFFSET		(11 * __SIZEOF_POINTER__)
 /** Maximum size of sbi_scratch and sbi_ipi_data */
-#define SBI_SCRATCH_SIZE			(64 * __SIZEOF_POINTER__)
+#if __riscv_xlen == 64
+#define SBI_SCRATCH_SIZE			0xc00
+#else
+#define SBI_SCRATCH_SIZE			0x800
+#endif
+/**
+ * HART stack size for platforms which want @__stack bytes of stack
+ * below the scratch space carved from the top of each HART stack
+ */
+#define SBI_SCRATCH_HART_STACK_SIZE(__stack)	((__stack) + SBI_SCRATCH_SIZE)
 
 /* clang-format on */
 
@@ -68,6 +79,8 @@ struct sbi_scratch {
 	unsigned long tmp0;
 	/** Options for OpenSBI library */
 	unsigned long options;
+	/** Temporary storage (mcycle at trap entry) */
+	unsigned long tmp1;
 } __packed;
 
 /** Possible options for OpenSBI library */
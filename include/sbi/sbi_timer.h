@@ -12,8 +12,63 @@
 
 #include <sbi/sbi_types.h>
 
+/* clang-format off */
+
+/** Maximum number of pending firmware timer events per HART */
+#define SBI_TIMER_MAX_EVENTS			4
+
+/** Heap slot of a timer event which is not pending */
+#define SBI_TIMER_EVENT_IDLE			((u32)-1)
+
+/* clang-format on */
+
 struct sbi_scratch;
 
+/**
+ * Firmware internal timer event
+ *
+ * Events are queued on the HART which adds them and the handler runs on
+ * that HART from the M-mode timer interrupt. A handler may re-add its
+ * own event to make it periodic.
+ */
+struct sbi_timer_event {
+	/** Absolute deadline in timer ticks */
+	u64 deadline;
+	/** Called once the deadline has passed */
+	void (*handler)(struct sbi_scratch *scratch,
+			struct sbi_timer_event *ev);
+	/** Private data of the handler */
+	void *priv;
+	/** Heap slot while pending, SBI_TIMER_EVENT_IDLE otherwise */
+	u32 slot;
+};
+
+#define SBI_TIMER_EVENT_INITIALIZER(__handler, __priv)	\
+	{						\
+		.deadline = 0,				\
+		.handler = (__handler),			\
+		.priv = (__priv),			\
+		.slot = SBI_TIMER_EVENT_IDLE,		\
+	}
+
+/** Initialize a timer event which is not pending */
+static inline void sbi_timer_event_init(struct sbi_timer_event *ev,
+					void (*handler)(struct sbi_scratch *,
+							struct sbi_timer_event *),
+					void *priv)
+{
+	ev->deadline = 0;
+	ev->handler = handler;
+	ev->priv = priv;
+	ev->slot = SBI_TIMER_EVENT_IDLE;
+}
+
+/** Check whether a timer event is queued */
+static inline bool sbi_timer_event_pending(const struct sbi_timer_event *ev)
+{
+	return (ev->slot != SBI_TIMER_EVENT_IDLE) ? TRUE : FALSE;
+}
+
 u64 sbi_timer_value(struct sbi_scratch *scratch);
 
 u64 sbi_timer_virt_value(struct sbi_scratch *scratch);
@@ -24,8 +79,38 @@ void sbi_timer_set_delta(struct sbi_scratch *scratch, ulong delta);
 
 void sbi_timer_set_delta_upper(struct sbi_scratch *scratch, ulong delta_upper);
 
+/**
+ * Queue or re-arm a firmware timer event on current HART
+ * @param scratch pointer to sbi_scratch of current HART
+ * @param ev the timer event
+ * @param deadline absolute deadline in timer ticks
+ *
+ * @return 0 on success, SBI_ENOSPC if the queue is full and
+ * SBI_EINVAL for an event without handler
+ */
+int sbi_timer_event_add(struct sbi_scratch *scratch,
+			struct sbi_timer_event *ev, u64 deadline);
+
+/**
+ * Remove a firmware timer event from the queue of current HART
+ * @param scratch pointer to sbi_scratch of current HART
+ * @param ev the timer event, ignored when not pending
+ */
+void sbi_timer_event_cancel(struct sbi_scratch *scratch,
+			    struct sbi_timer_event *ev);
+
+/** Cancel the S-mode timer deadline of current HART */
 void sbi_timer_event_stop(struct sbi_scratch *scratch);
 
+/**
+ * Program the S-mode timer deadline of current HART
+ *
+ * The S-mode deadline shares the timer queue with firmware events and
+ * MIP.STIP is raised only when it expires. Repeating the pending
+ * deadline does not touch the heap or the timer device. The timer
+ * device must only be programmed through the sbi_timer_event_*()
+ * functions.
+ */
 void sbi_timer_event_start(struct sbi_scratch *scratch, u64 next_event);
 
 void sbi_timer_process(struct sbi_scratch *scratch);
@@ -12,11 +12,20 @@
 #define __SBI_TLB_H__
 
 #include <sbi/sbi_types.h>
+#include <sbi/sbi_hartmask.h>
 
 /* clang-format off */
 
 #define SBI_TLB_FLUSH_ALL			((unsigned long)-1)
 
+#define SBI_TLB_STRIDE_4K			(1UL << 12)
+#if __riscv_xlen == 64
+#define SBI_TLB_STRIDE_2M			(1UL << 21)
+#define SBI_TLB_STRIDE_1G			(1UL << 30)
+#else
+#define SBI_TLB_STRIDE_4M			(1UL << 22)
+#endif
+
 /* clang-format on */
 
 #define SBI_TLB_FIFO_NUM_ENTRIES		8
@@ -24,7 +33,10 @@
 enum sbi_tlb_info_types {
 	SBI_TLB_FLUSH_VMA,
 	SBI_TLB_FLUSH_VMA_ASID,
-	SBI_TLB_FLUSH_VMA_VMID,
+	SBI_TLB_FLUSH_GVMA_VMID,
+	SBI_TLB_FLUSH_GVMA,
+	SBI_TLB_FLUSH_VVMA_ASID,
+	SBI_TLB_FLUSH_VVMA,
 	SBI_ITLB_FLUSH
 };
 
@@ -34,8 +46,11 @@ struct sbi_tlb_info {
 	unsigned long start;
 	unsigned long size;
 	unsigned long asid;
+	unsigned long vmid;
 	unsigned long type;
-	unsigned long shart_mask;
+	/** Flush stride hint (mapping page size), zero means 4KB */
+	unsigned long stride;
+	struct sbi_hartmask shart_mask;
 };
 
 #define SBI_TLB_INFO_SIZE			sizeof(struct sbi_tlb_info)
@@ -48,4 +63,27 @@ int sbi_tlb_fifo_init(struct sbi_scratch *scratch, bool cold_boot);
 
 void sbi_tlb_fifo_sync(struct sbi_scratch *scratch);
 
+unsigned long sbi_tlb_range_flush_limit(void);
+
+/**
+ * Check whether a stride hint is a supported leaf page size
+ * @param stride the stride hint (zero selects the default)
+ */
+static inline bool sbi_tlb_stride_valid(unsigned long stride)
+{
+	switch (stride) {
+	case 0:
+	case SBI_TLB_STRIDE_4K:
+#if __riscv_xlen == 64
+	case SBI_TLB_STRIDE_2M:
+	case SBI_TLB_STRIDE_1G:
+#else
+	case SBI_TLB_STRIDE_4M:
+#endif
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
 #endif
@@ -82,8 +82,22 @@
 #define SBI_TRAP_REGS_mstatus			33
 /** Index of mstatusH member in sbi_trap_regs */
 #define SBI_TRAP_REGS_mstatusH			34
+/** Index of mcycle member in sbi_trap_regs */
+#define SBI_TRAP_REGS_mcycle			35
+/** Index of stat_cycles member in sbi_trap_regs */
+#define SBI_TRAP_REGS_stat_cycles		36
 /** Last member index in sbi_trap_regs */
-#define SBI_TRAP_REGS_last			35
+#define SBI_TRAP_REGS_last			37
+
+/**
+ * SBI calls handled by the trap entry fast path (the values of
+ * SBI_EXT_0_1_SET_TIMER, SBI_EXT_0_1_CLEAR_IPI, SBI_EXT_TIME and
+ * SBI_EXT_TIME_SET_TIMER for assembly code)
+ */
+#define SBI_TRAP_FAST_EXT_SET_TIMER		0x0
+#define SBI_TRAP_FAST_EXT_CLEAR_IPI		0x3
+#define SBI_TRAP_FAST_EXT_TIME			0x54494D45
+#define SBI_TRAP_FAST_TIME_SET_TIMER		0x0
 
 /* clang-format on */
 
@@ -94,6 +108,7 @@
 
 #ifndef __ASSEMBLY__
 
+#include <sbi/sbi_ecall_interface.h>
 #include <sbi/sbi_types.h>
 
 /** Representation of register state at time of trap/interrupt */
@@ -168,6 +183,13 @@ struct sbi_trap_regs {
 	unsigned long mstatus;
 	/** mstatusH register state (only for 32-bit) */
 	unsigned long mstatusH;
+	/** mcycle value read by the trap entry code */
+	unsigned long mcycle;
+	/**
+	 * Address of the trap statistics cycle count which the trap exit
+	 * code adds mcycle to right before mret (zero for none)
+	 */
+	unsigned long stat_cycles;
 };
 
 /** Representation of trap details */
@@ -180,8 +202,22 @@ struct sbi_trap_info {
 	unsigned long tval;
 };
 
+/** Per-HART trap statistics indexed by enum sbi_fw_debug_trap_stat */
+struct sbi_trap_stats {
+	/** Number of traps handled */
+	unsigned long count[SBI_FW_DEBUG_TRAP_STAT_MAX];
+	/** mcycle spent in M-mode handling the traps */
+	unsigned long cycles[SBI_FW_DEBUG_TRAP_STAT_MAX];
+};
+
 struct sbi_scratch;
 
+struct sbi_trap_stats *sbi_trap_stats_ptr(struct sbi_scratch *scratch);
+
+void sbi_trap_stats_reset(struct sbi_scratch *scratch);
+
+int sbi_trap_stats_init(struct sbi_scratch *scratch, bool cold_boot);
+
 int sbi_trap_redirect(struct sbi_trap_regs *regs,
 		      struct sbi_trap_info *trap,
 		      struct sbi_scratch *scratch);
@@ -189,6 +225,9 @@ int sbi_trap_redirect(struct sbi_trap_regs *regs,
 void sbi_trap_handler(struct sbi_trap_regs *regs,
 		      struct sbi_scratch *scratch);
 
+void sbi_trap_handler_fast(struct sbi_trap_regs *regs,
+			   struct sbi_scratch *scratch);
+
 #endif
 
 #endif
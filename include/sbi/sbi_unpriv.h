@@ -41,4 +41,33 @@ DECLARE_UNPRIVILEGED_LOAD_FUNCTION(ulong)
 ulong sbi_get_insn(ulong mepc, struct sbi_scratch *scratch,
 		   struct sbi_trap_info *trap);
 
+/**
+ * Copy from a physical address of the previous privilege mode
+ *
+ * Address translation is suspended during the copy, so the range is
+ * physical while PMP still checks the rights of the previous mode.
+ * @param dst destination buffer in firmware memory
+ * @param src physical source address
+ * @param len number of bytes to copy
+ * @param scratch pointer to sbi_scratch of current HART
+ * @param trap filled in when an access faults
+ *
+ * @return number of bytes copied before any fault
+ */
+ulong sbi_load_phys(void *dst, ulong src, ulong len,
+		    struct sbi_scratch *scratch, struct sbi_trap_info *trap);
+
+/**
+ * Copy to a physical address of the previous privilege mode
+ * @param dst physical destination address
+ * @param src source buffer in firmware memory
+ * @param len number of bytes to copy
+ * @param scratch pointer to sbi_scratch of current HART
+ * @param trap filled in when an access faults
+ *
+ * @return number of bytes copied before any fault
+ */
+ulong sbi_store_phys(ulong dst, const void *src, ulong len,
+		     struct sbi_scratch *scratch, struct sbi_trap_info *trap);
+
 #endif
@@ -22,4 +22,12 @@ void plic_set_thresh(u32 cntxid, u32 val);
 
 void plic_set_ie(u32 cntxid, u32 word_index, u32 val);
 
+void plic_set_priority(u32 source, u32 val);
+
+u32 plic_claim(u32 cntxid);
+
+void plic_complete(u32 cntxid, u32 source);
+
+int plic_mmode_enable(u32 m_cntx_id, u32 source);
+
 #endif
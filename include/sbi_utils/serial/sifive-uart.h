@@ -14,8 +14,14 @@
 
 void sifive_uart_putc(char ch);
 
+int sifive_uart_try_putc(char ch);
+
+int sifive_uart_puts(const char *str, size_t len);
+
 int sifive_uart_getc(void);
 
+void sifive_uart_rx_irq_enable(void);
+
 int sifive_uart_init(unsigned long base, u32 in_freq, u32 baudrate);
 
 #endif
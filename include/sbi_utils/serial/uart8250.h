@@ -14,8 +14,14 @@
 
 void uart8250_putc(char ch);
 
+int uart8250_try_putc(char ch);
+
+int uart8250_puts(const char *str, size_t len);
+
 int uart8250_getc(void);
 
+void uart8250_rx_irq_enable(void);
+
 int uart8250_init(unsigned long base, u32 in_freq, u32 baudrate, u32 reg_shift,
 		  u32 reg_width);
 
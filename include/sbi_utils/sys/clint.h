@@ -14,6 +14,8 @@
 
 void clint_ipi_send(u32 target_hart);
 
+void clint_ipi_send_mask(ulong mask, ulong base);
+
 void clint_ipi_sync(u32 target_hart);
 
 void clint_ipi_clear(u32 target_hart);
@@ -8,7 +8,6 @@
 #
 
 libsbi-objs-y += riscv_asm.o
-libsbi-objs-y += riscv_atomic.o
 libsbi-objs-y += riscv_hardfp.o
 libsbi-objs-y += riscv_locks.o
 
@@ -17,9 +16,11 @@ libsbi-objs-y += sbi_ecall.o
 libsbi-objs-y += sbi_emulate_csr.o
 libsbi-objs-y += sbi_fifo.o
 libsbi-objs-y += sbi_hart.o
+libsbi-objs-y += sbi_hfence.o
 libsbi-objs-y += sbi_illegal_insn.o
 libsbi-objs-y += sbi_init.o
 libsbi-objs-y += sbi_ipi.o
+libsbi-objs-y += sbi_log.o
 libsbi-objs-y += sbi_misaligned_ldst.o
 libsbi-objs-y += sbi_scratch.o
 libsbi-objs-y += sbi_system.o
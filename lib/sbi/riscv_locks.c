@@ -7,39 +7,294 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
+#include <sbi/riscv_atomic.h>
 #include <sbi/riscv_barrier.h>
 #include <sbi/riscv_locks.h>
+#ifdef SBI_LOCK_STATS
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_encoding.h>
+#include <sbi/sbi_console.h>
+#endif
+
+#define TICKET_SHIFT	16
+
+#ifdef SBI_LOCK_STATS
+static spinlock_t *lock_stats_table[SPIN_LOCK_STATS_MAX];
+
+void spin_lock_stats_init(spinlock_t *lock, const char *name)
+{
+	lock->stats.name       = name;
+	lock->stats.acquired   = 0;
+	lock->stats.contended  = 0;
+	lock->stats.spins      = 0;
+	lock->stats.max_hold   = 0;
+	lock->stats.hold_start = 0;
+	lock->stats.registered = FALSE;
+}
+
+static void __spin_lock_stats_register(spinlock_t *lock)
+{
+	u32 i;
+	volatile unsigned long *slot;
+
+	/*
+	 * Slots are filled in order and never freed so the first empty
+	 * slot ends the search. A lock re-initialized after registration
+	 * finds itself and is not added twice.
+	 */
+	for (i = 0; i < SPIN_LOCK_STATS_MAX; i++) {
+		slot = (volatile unsigned long *)&lock_stats_table[i];
+		if (*slot == (unsigned long)lock)
+			break;
+		if (!*slot &&
+		    !atomic_raw_cmpxchg_ulong(slot, 0, (unsigned long)lock))
+			break;
+	}
+
+	lock->stats.registered = TRUE;
+}
+
+static void __spin_lock_stats_acquired(spinlock_t *lock, unsigned long spins)
+{
+	struct spinlock_stats *st = &lock->stats;
+
+	if (!st->registered)
+		__spin_lock_stats_register(lock);
+
+	st->acquired++;
+	if (spins) {
+		st->contended++;
+		st->spins += spins;
+	}
+	st->hold_start = csr_read(CSR_MCYCLE);
+}
+
+static void __spin_lock_stats_release(spinlock_t *lock)
+{
+	struct spinlock_stats *st = &lock->stats;
+	unsigned long hold = csr_read(CSR_MCYCLE) - st->hold_start;
+
+	if (st->max_hold < hold)
+		st->max_hold = hold;
+}
+
+u32 spin_lock_stats_count(void)
+{
+	u32 i;
+
+	for (i = 0; i < SPIN_LOCK_STATS_MAX; i++)
+		if (!lock_stats_table[i])
+			break;
+
+	return i;
+}
+
+const struct spinlock_stats *spin_lock_stats_get(u32 index)
+{
+	if (index >= SPIN_LOCK_STATS_MAX || !lock_stats_table[index])
+		return NULL;
+
+	return &lock_stats_table[index]->stats;
+}
+
+void spin_lock_stats_reset(void)
+{
+	u32 i;
+	struct spinlock_stats *st;
+
+	/* Racy against current holders, counters are only a hint anyway */
+	for (i = 0; i < SPIN_LOCK_STATS_MAX && lock_stats_table[i]; i++) {
+		st = &lock_stats_table[i]->stats;
+		st->acquired  = 0;
+		st->contended = 0;
+		st->spins     = 0;
+		st->max_hold  = 0;
+	}
+}
+
+void spin_lock_stats_dump(void)
+{
+	u32 i;
+	spinlock_t *lock;
+	const struct spinlock_stats *st;
+
+	sbi_printf("%-20s %12s %12s %12s %12s\n", "Lock", "Acquired",
+		   "Contended", "Spins", "MaxHold");
+	for (i = 0; i < SPIN_LOCK_STATS_MAX && lock_stats_table[i]; i++) {
+		lock = lock_stats_table[i];
+		st = &lock->stats;
+		if (st->name)
+			sbi_printf("%-20s", st->name);
+		else
+			sbi_printf("lock@0x%-13p", lock);
+		sbi_printf(" %12llu %12llu %12llu %12llu\n",
+			   (unsigned long long)st->acquired,
+			   (unsigned long long)st->contended,
+			   (unsigned long long)st->spins,
+			   (unsigned long long)st->max_hold);
+	}
+}
+#endif
 
 int spin_lock_check(spinlock_t *lock)
 {
-	return (lock->lock == __RISCV_SPIN_UNLOCKED) ? 0 : 1;
+	return (lock->owner == lock->next) ? 0 : 1;
 }
 
 int spin_trylock(spinlock_t *lock)
 {
-	int tmp = 1, busy;
+	unsigned long inc = 1UL << TICKET_SHIFT;
+	unsigned long mask = 0xffffUL << TICKET_SHIFT;
+	u32 l0, tmp1, tmp2;
 
 	__asm__ __volatile__(
-		"	amoswap.w %0, %2, %1\n" RISCV_ACQUIRE_BARRIER
-		: "=r"(busy), "+A"(lock->lock)
-		: "r"(tmp)
+		/* Get the current lock counters */
+		"1:	lr.w.aq	%0, %3\n"
+		"	slli	%2, %0, %6\n"
+		"	and	%2, %2, %5\n"
+		"	and	%1, %0, %5\n"
+		/* Is the lock free right now? */
+		"	bne	%1, %2, 2f\n"
+		"	add	%0, %0, %4\n"
+		/* Acquire the lock by taking the next ticket */
+		"	sc.w.rl	%0, %0, %3\n"
+		"	bnez	%0, 1b\n"
+		"2:"
+		: "=&r"(l0), "=&r"(tmp1), "=&r"(tmp2), "+A"(*lock)
+		: "r"(inc), "r"(mask), "I"(TICKET_SHIFT)
 		: "memory");
 
-	return !busy;
+#ifdef SBI_LOCK_STATS
+	if (l0 == 0)
+		__spin_lock_stats_acquired(lock, 0);
+#endif
+
+	return l0 == 0;
 }
 
+#ifdef SBI_LOCK_STATS
 void spin_lock(spinlock_t *lock)
 {
-	while (1) {
-		if (spin_lock_check(lock))
-			continue;
+	unsigned long spins = 0;
+	u32 l0;
+	u16 ticket;
 
-		if (spin_trylock(lock))
-			break;
+	/* Same protocol as below but counting spin iterations */
+	__asm__ __volatile__("	amoadd.w.aqrl	%0, %2, %1\n"
+			     : "=r"(l0), "+A"(*lock)
+			     : "r"(1UL << TICKET_SHIFT)
+			     : "memory");
+
+	ticket = l0 >> TICKET_SHIFT;
+	while ((u16)l0 != ticket) {
+		spins++;
+		cpu_relax();
+		l0 = lock->owner;
 	}
+	RISCV_FENCE(r, rw);
+
+	__spin_lock_stats_acquired(lock, spins);
+}
+#else
+void spin_lock(spinlock_t *lock)
+{
+	unsigned long inc = 1UL << TICKET_SHIFT;
+	unsigned long mask = 0xffffUL;
+	u32 l0, tmp1, tmp2;
+
+	__asm__ __volatile__(
+		/* Atomically take the next ticket */
+		"	amoadd.w.aqrl	%0, %4, %3\n"
+		/* Did we get the lock? */
+		"	srli	%1, %0, %6\n"
+		"	and	%1, %1, %5\n"
+		"1:	and	%2, %0, %5\n"
+		"	beq	%1, %2, 2f\n"
+		/* If not, then spin until owner reaches our ticket */
+		"	lw	%0, %3\n"
+		RISCV_ACQUIRE_BARRIER
+		"	j	1b\n"
+		"2:"
+		: "=&r"(l0), "=&r"(tmp1), "=&r"(tmp2), "+A"(*lock)
+		: "r"(inc), "r"(mask), "I"(TICKET_SHIFT)
+		: "memory");
 }
+#endif
 
 void spin_unlock(spinlock_t *lock)
 {
-	__smp_store_release(&lock->lock, __RISCV_SPIN_UNLOCKED);
+#ifdef SBI_LOCK_STATS
+	__spin_lock_stats_release(lock);
+#endif
+	/* Only the lock holder updates owner so no atomic needed */
+	__smp_store_release(&lock->owner, lock->owner + 1);
+}
+
+int read_trylock(rwlock_t *lock)
+{
+	long val = lock->lock;
+
+	if (val == __RISCV_RW_WRITER)
+		return 0;
+
+	/* Compare-and-swap is a full barrier so acts as acquire */
+	return (atomic_raw_cmpxchg_ulong((volatile unsigned long *)&lock->lock,
+					 val, val + 1) == val) ? 1 : 0;
+}
+
+void read_lock(rwlock_t *lock)
+{
+	while (!read_trylock(lock))
+		cpu_relax();
+}
+
+void read_unlock(rwlock_t *lock)
+{
+	long tmp;
+
+	__asm__ __volatile__(
+#if __riscv_xlen == 64
+		"	amoadd.d.rl	%0, %2, %1\n"
+#else
+		"	amoadd.w.rl	%0, %2, %1\n"
+#endif
+		: "=r"(tmp), "+A"(lock->lock)
+		: "r"(-1L)
+		: "memory");
+}
+
+int write_trylock(rwlock_t *lock)
+{
+	if (lock->lock != __RISCV_RW_UNLOCKED)
+		return 0;
+
+	return (atomic_raw_cmpxchg_ulong((volatile unsigned long *)&lock->lock,
+					 __RISCV_RW_UNLOCKED,
+					 __RISCV_RW_WRITER) ==
+		__RISCV_RW_UNLOCKED) ? 1 : 0;
+}
+
+void write_lock(rwlock_t *lock)
+{
+	while (!write_trylock(lock))
+		cpu_relax();
+}
+
+void write_unlock(rwlock_t *lock)
+{
+	__smp_store_release(&lock->lock, __RISCV_RW_UNLOCKED);
+}
+
+void write_seqlock(seqlock_t *sl)
+{
+	spin_lock(&sl->lock);
+	sl->sequence++;
+	smp_wmb();
+}
+
+void write_sequnlock(seqlock_t *sl)
+{
+	smp_wmb();
+	sl->sequence++;
+	spin_unlock(&sl->lock);
 }
@@ -7,12 +7,169 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
-#include <sbi/sbi_platform.h>
+#include <sbi/riscv_asm.h>
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
 #include <sbi/sbi_console.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_platform.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_timer.h>
 #include <sbi/riscv_locks.h>
 
 static const struct sbi_platform *console_plat = NULL;
-static spinlock_t console_out_lock	       = SPIN_LOCK_INITIALIZER;
+static spinlock_t console_out_lock	       =
+	SPIN_LOCK_NAMED_INITIALIZER("console_out");
+
+/*
+ * Per-HART console output ring
+ *
+ * Only the owning HART writes bytes and advances the tail. Whichever
+ * HART holds console_out_lock drains any ring and advances its head,
+ * so printing never waits for the UART unless a ring is full.
+ */
+struct sbi_console_ring {
+	volatile u32 head;
+	volatile u32 tail;
+	/* Retries draining while the ring has backlog */
+	struct sbi_timer_event drain_event;
+	char buf[SBI_CONSOLE_RING_SIZE];
+};
+
+#define CONSOLE_RING_MASK	(SBI_CONSOLE_RING_SIZE - 1)
+
+/*
+ * Console receive ring
+ *
+ * Filled from the receive interrupt of the one HART it is routed to
+ * and emptied by any HART under console_in_lock, so reading input
+ * touches no device registers once the interrupt is set up.
+ */
+struct sbi_console_rx_ring {
+	volatile u32 head;
+	volatile u32 tail;
+	char buf[SBI_CONSOLE_RX_RING_SIZE];
+};
+
+#define CONSOLE_RX_RING_MASK	(SBI_CONSOLE_RX_RING_SIZE - 1)
+
+static struct sbi_console_rx_ring console_rx;
+static u32 console_rx_irq;
+static spinlock_t console_in_lock = SPIN_LOCK_NAMED_INITIALIZER("console_in");
+
+static unsigned long console_ring_off;
+static struct sbi_hartmask console_ring_harts = { 0 };
+static volatile bool console_sync	       = FALSE;
+
+static struct sbi_console_ring *console_ring_this(void)
+{
+	if (console_sync ||
+	    !sbi_hartmask_test_hart(sbi_current_hartid(), &console_ring_harts))
+		return NULL;
+
+	return sbi_scratch_thishart_offset_ptr(console_ring_off);
+}
+
+/*
+ * Write out one ring, called with console_out_lock held. Contiguous
+ * runs go to the UART in bursts. Without wait it stops as soon as the
+ * transmitter is full and returns FALSE.
+ */
+static bool console_ring_drain(struct sbi_console_ring *ring, bool wait)
+{
+	u32 head = ring->head;
+	u32 tail = ring->tail;
+	u32 off, len;
+	int n;
+
+	smp_rmb();
+	while (head != tail) {
+		off = head & CONSOLE_RING_MASK;
+		len = tail - head;
+		if (len > (SBI_CONSOLE_RING_SIZE - off))
+			len = SBI_CONSOLE_RING_SIZE - off;
+
+		n = sbi_platform_console_puts(console_plat, &ring->buf[off],
+					      len);
+		head += n;
+		if ((u32)n < len && !wait)
+			break;
+	}
+	smp_mb();
+	ring->head = head;
+
+	return (head == tail) ? TRUE : FALSE;
+}
+
+static void console_drain_all(bool wait)
+{
+	u32 h;
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+
+	sbi_hartmask_for_each_hart(h, &console_ring_harts) {
+		if (!console_ring_drain(sbi_scratch_offset_ptr(
+					sbi_hart_id_to_scratch(scratch, h),
+					console_ring_off), wait))
+			break;
+	}
+}
+
+/* Drain whatever the UART takes now and retry later on backlog */
+static void console_ring_kick(struct sbi_console_ring *ring)
+{
+	struct sbi_scratch *scratch;
+
+	if (spin_trylock(&console_out_lock)) {
+		console_drain_all(FALSE);
+		spin_unlock(&console_out_lock);
+	}
+
+	if (ring->head == ring->tail ||
+	    sbi_timer_event_pending(&ring->drain_event))
+		return;
+
+	scratch = sbi_scratch_thishart_ptr();
+	sbi_timer_event_add(scratch, &ring->drain_event,
+			    sbi_timer_value(scratch) + SBI_CONSOLE_DRAIN_DELAY);
+}
+
+static void console_drain_expired(struct sbi_scratch *scratch,
+				  struct sbi_timer_event *ev)
+{
+	console_ring_kick(ev->priv);
+}
+
+static void console_ring_put(struct sbi_console_ring *ring, char ch)
+{
+	/* Never drop output, wait for the UART when the ring is full */
+	if ((ring->tail - ring->head) >= SBI_CONSOLE_RING_SIZE) {
+		spin_lock(&console_out_lock);
+		console_ring_drain(ring, TRUE);
+		spin_unlock(&console_out_lock);
+	}
+
+	ring->buf[ring->tail & CONSOLE_RING_MASK] = ch;
+	smp_wmb();
+	ring->tail = ring->tail + 1;
+}
+
+static void console_emit(char ch)
+{
+	struct sbi_console_ring *ring = console_ring_this();
+
+	if (!ring) {
+		if (ch == '\n')
+			sbi_platform_console_putc(console_plat, '\r');
+		sbi_platform_console_putc(console_plat, ch);
+		return;
+	}
+
+	if (ch == '\n')
+		console_ring_put(ring, '\r');
+	console_ring_put(ring, ch);
+}
 
 bool sbi_isprintable(char c)
 {
@@ -23,26 +180,82 @@ bool sbi_isprintable(char c)
 	return FALSE;
 }
 
+static ulong console_rx_read(char *str, ulong len)
+{
+	u32 head, tail;
+	ulong i = 0;
+
+	/*
+	 * M-mode runs with interrupts disabled, so the HART owning the
+	 * receive interrupt fills the ring itself when input is pending.
+	 */
+	if (csr_read(CSR_MIP) & MIP_MEIP)
+		sbi_console_irq_process(NULL);
+
+	spin_lock(&console_in_lock);
+	head = console_rx.head;
+	tail = console_rx.tail;
+	smp_rmb();
+	for (; i < len && head != tail; i++, head++)
+		str[i] = console_rx.buf[head & CONSOLE_RX_RING_MASK];
+	smp_mb();
+	console_rx.head = head;
+	spin_unlock(&console_in_lock);
+
+	return i;
+}
+
 int sbi_getc(void)
 {
-	return sbi_platform_console_getc(console_plat);
+	char ch;
+
+	if (!console_rx_irq)
+		return sbi_platform_console_getc(console_plat);
+
+	return console_rx_read(&ch, 1) ? (u8)ch : -1;
 }
 
 void sbi_putc(char ch)
 {
-	if (ch == '\n')
-		sbi_platform_console_putc(console_plat, '\r');
-	sbi_platform_console_putc(console_plat, ch);
+	struct sbi_console_ring *ring;
+
+	console_emit(ch);
+	ring = console_ring_this();
+	if (ring)
+		console_ring_kick(ring);
 }
 
 void sbi_puts(const char *str)
 {
-	spin_lock(&console_out_lock);
+	struct sbi_console_ring *ring = console_ring_this();
+
+	if (!ring)
+		spin_lock(&console_out_lock);
 	while (*str) {
-		sbi_putc(*str);
+		console_emit(*str);
 		str++;
 	}
-	spin_unlock(&console_out_lock);
+	if (ring)
+		console_ring_kick(ring);
+	else
+		spin_unlock(&console_out_lock);
+}
+
+ulong sbi_nputs(const char *str, ulong len)
+{
+	ulong i;
+	struct sbi_console_ring *ring = console_ring_this();
+
+	if (!ring)
+		spin_lock(&console_out_lock);
+	for (i = 0; i < len; i++)
+		console_emit(str[i]);
+	if (ring)
+		console_ring_kick(ring);
+	else
+		spin_unlock(&console_out_lock);
+
+	return len;
 }
 
 void sbi_gets(char *s, int maxwidth, char endchar)
@@ -58,6 +271,24 @@ void sbi_gets(char *s, int maxwidth, char endchar)
 	*retval = '\0';
 }
 
+ulong sbi_ngets(char *str, ulong len)
+{
+	int ch;
+	ulong i;
+
+	if (console_rx_irq)
+		return console_rx_read(str, len);
+
+	for (i = 0; i < len; i++) {
+		ch = sbi_getc();
+		if (ch < 0)
+			break;
+		str[i] = (char)ch;
+	}
+
+	return i;
+}
+
 #define PAD_RIGHT 1
 #define PAD_ZERO 2
 #define PAD_ALTERNATE 4
@@ -82,7 +313,7 @@ static void printc(char **out, u32 *out_len, char ch)
 			}
 		}
 	} else {
-		sbi_putc(ch);
+		console_emit(ch);
 	}
 }
 
@@ -361,16 +592,30 @@ int sbi_snprintf(char *out, u32 out_sz, const char *format, ...)
 	return retval;
 }
 
+static int console_vprintf(const char *format, va_list args)
+{
+	int retval;
+	struct sbi_console_ring *ring = console_ring_this();
+
+	if (!ring)
+		spin_lock(&console_out_lock);
+	retval = print(NULL, NULL, format, args);
+	if (ring)
+		console_ring_kick(ring);
+	else
+		spin_unlock(&console_out_lock);
+
+	return retval;
+}
+
 int sbi_printf(const char *format, ...)
 {
 	va_list args;
 	int retval;
 
-	spin_lock(&console_out_lock);
 	va_start(args, format);
-	retval = print(NULL, NULL, format, args);
+	retval = console_vprintf(format, args);
 	va_end(args);
-	spin_unlock(&console_out_lock);
 
 	return retval;
 }
@@ -382,15 +627,120 @@ int sbi_dprintf(struct sbi_scratch *scratch, const char *format, ...)
 
 	va_start(args, format);
 	if (scratch->options & SBI_SCRATCH_DEBUG_PRINTS)
-		retval = print(NULL, NULL, format, args);
+		retval = console_vprintf(format, args);
 	va_end(args);
 
 	return retval;
 }
 
+void sbi_console_flush(void)
+{
+	spin_lock(&console_out_lock);
+	console_drain_all(TRUE);
+	spin_unlock(&console_out_lock);
+}
+
+void sbi_console_panic(void)
+{
+	bool locked;
+
+	console_sync = TRUE;
+	smp_mb();
+
+	/* A HART stuck with the lock must not hide the error report */
+	locked = spin_trylock(&console_out_lock);
+	console_drain_all(TRUE);
+	if (locked)
+		spin_unlock(&console_out_lock);
+}
+
+int sbi_console_irq_process(struct sbi_scratch *scratch)
+{
+	u32 irq, tail;
+	int ch;
+
+	irq = sbi_platform_irqchip_claim(console_plat);
+	if (!irq)
+		return 0;
+	if (irq != console_rx_irq) {
+		sbi_platform_irqchip_complete(console_plat, irq);
+		return SBI_ENODEV;
+	}
+
+	/* The device FIFO is emptied even if the ring is full */
+	tail = console_rx.tail;
+	while ((ch = sbi_platform_console_getc(console_plat)) >= 0) {
+		if ((tail - console_rx.head) >= SBI_CONSOLE_RX_RING_SIZE)
+			continue;
+		console_rx.buf[tail & CONSOLE_RX_RING_MASK] = (char)ch;
+		tail++;
+	}
+	smp_wmb();
+	console_rx.tail = tail;
+
+	sbi_platform_irqchip_complete(console_plat, irq);
+
+	return 0;
+}
+
+int sbi_console_irq_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+#ifdef SBI_CONSOLE_RX_IRQ
+	int rc;
+
+	if (!cold_boot)
+		return 0;
+
+	/* Without a usable receive interrupt the console keeps polling */
+	rc = sbi_platform_console_irq_init(console_plat);
+	if (rc == 0 || rc == SBI_ENOTSUPP)
+		return 0;
+	if (rc < 0)
+		return rc;
+
+	console_rx.head = 0;
+	console_rx.tail = 0;
+	console_rx_irq	= rc;
+	smp_wmb();
+	csr_set(CSR_MIE, MIP_MEIP);
+#endif
+
+	return 0;
+}
+
 int sbi_console_init(struct sbi_scratch *scratch)
 {
 	console_plat = sbi_platform_ptr(scratch);
 
 	return sbi_platform_console_init(console_plat);
 }
+
+int sbi_console_ring_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	struct sbi_console_ring *ring;
+	u32 hartid = sbi_current_hartid();
+
+	if (cold_boot) {
+		console_ring_off = sbi_scratch_alloc_offset(sizeof(*ring),
+							    "CONSOLE_RING");
+		if (!console_ring_off)
+			return SBI_ENOMEM;
+	} else {
+		if (!console_ring_off)
+			return SBI_ENOMEM;
+	}
+
+	/* HARTs outside the hartmask keep writing synchronously */
+	if (hartid >= SBI_HARTMASK_MAX_BITS)
+		return 0;
+
+	ring = sbi_scratch_offset_ptr(scratch, console_ring_off);
+	ring->head = 0;
+	ring->tail = 0;
+	sbi_timer_event_init(&ring->drain_event, console_drain_expired, ring);
+
+	atomic_raw_set_bit_release(hartid,
+				   sbi_hartmask_bits(&console_ring_harts));
+
+	return 0;
+}
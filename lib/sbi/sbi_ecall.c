@@ -13,13 +13,18 @@
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_platform.h>
+#include <sbi/sbi_string.h>
 #include <sbi/sbi_system.h>
 #include <sbi/sbi_timer.h>
 #include <sbi/sbi_tlb.h>
 #include <sbi/sbi_trap.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_log.h>
+#include <sbi/sbi_unpriv.h>
 #include <sbi/sbi_version.h>
 #include <sbi/riscv_asm.h>
+#include <sbi/riscv_locks.h>
 
 #ifdef WITH_SM
 #include <sm_sbi_opensbi.h>
@@ -40,74 +45,138 @@ u16 sbi_ecall_version_minor(void)
 	return SBI_ECALL_VERSION_MINOR;
 }
 
-int sbi_check_extension(struct sbi_scratch *scratch, unsigned long extid,
-			unsigned long *out_val)
+/* Registered extensions sorted by extid_start, ranges never overlap */
+static struct sbi_ecall_extension *ecall_exts[SBI_ECALL_MAX_EXTENSIONS];
+static u32 ecall_exts_count;
+
+struct sbi_ecall_extension *sbi_ecall_find_extension(unsigned long extid)
 {
-	/**
-	 * Each extension apart from base & 0.1, will be implemented as
-	 * platform specific feature. Thus, extension probing can be achieved
-	 * by checking the feature bits of the platform. We can create a map
-	 * between extension ID & feature and use a generic function to check
-	 * or just use a switch case for every new extension support added
-	 * TODO: Implement it.
-	 */
+	u32 lo = 0, hi = ecall_exts_count, mid;
+	struct sbi_ecall_extension *ext;
 
-	if ((extid >= SBI_EXT_0_1_SET_TIMER &&
-	    extid <= SBI_EXT_0_1_SHUTDOWN) || (extid == SBI_EXT_BASE)) {
-		*out_val = 1;
-	} else if (extid >= SBI_EXT_VENDOR_START &&
-		   extid <= SBI_EXT_VENDOR_END) {
-		*out_val = sbi_platform_vendor_ext_check(
-						sbi_platform_ptr(scratch),
-						extid);
-	} else
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		ext = ecall_exts[mid];
+		if (extid < ext->extid_start)
+			hi = mid;
+		else if (ext->extid_end < extid)
+			lo = mid + 1;
+		else
+			return ext;
+	}
+
+	return NULL;
+}
+
+int sbi_ecall_register_extension(struct sbi_ecall_extension *ext)
+{
+	u32 i, pos;
+
+	if (!ext || !ext->handle || ext->extid_end < ext->extid_start)
+		return SBI_EINVAL;
+	if (ecall_exts_count >= SBI_ECALL_MAX_EXTENSIONS)
+		return SBI_ENOSPC;
+
+	for (pos = 0; pos < ecall_exts_count; pos++)
+		if (ext->extid_start < ecall_exts[pos]->extid_start)
+			break;
+
+	/* Reject overlap with the neighbours in sorted order */
+	if (pos > 0 && ext->extid_start <= ecall_exts[pos - 1]->extid_end)
+		return SBI_EINVAL;
+	if (pos < ecall_exts_count &&
+	    ecall_exts[pos]->extid_start <= ext->extid_end)
+		return SBI_EINVAL;
+
+	for (i = ecall_exts_count; i > pos; i--)
+		ecall_exts[i] = ecall_exts[i - 1];
+	ecall_exts[pos] = ext;
+	ecall_exts_count++;
+
+	return 0;
+}
+
+static int sbi_check_extension(struct sbi_scratch *scratch,
+			       unsigned long extid, unsigned long *out_val)
+{
+	struct sbi_ecall_extension *ext = sbi_ecall_find_extension(extid);
+
+	if (!ext)
 		*out_val = 0;
+	else if (ext->probe)
+		return ext->probe(scratch, extid, out_val);
+	else
+		*out_val = 1;
 
 	return 0;
 }
 
-int sbi_ecall_vendor_ext_handler(struct sbi_scratch *scratch,
-				 unsigned long extid, unsigned long funcid,
-				 unsigned long *args, unsigned long *out_val,
-				 struct sbi_trap_info *out_trap)
+static int sbi_ecall_vendor_probe(struct sbi_scratch *scratch,
+				  unsigned long extid, unsigned long *out_val)
 {
-	return sbi_platform_vendor_ext_provider(sbi_platform_ptr(scratch),
-						extid, funcid, args,
-						out_val, out_trap);
+	*out_val = sbi_platform_vendor_ext_check(sbi_platform_ptr(scratch),
+						 extid);
+	return 0;
+}
+
+static int sbi_ecall_vendor_handler(struct sbi_scratch *scratch,
+				    unsigned long extid, unsigned long funcid,
+				    struct sbi_trap_regs *regs,
+				    struct sbi_ecall_return *out,
+				    struct sbi_trap_info *out_trap)
+{
+	int ret;
+	unsigned long out_val[2] = { 0 };
+	unsigned long args[6] = { regs->a0, regs->a1, regs->a2,
+				  regs->a3, regs->a4, regs->a5 };
+
+	ret = sbi_platform_vendor_ext_provider(sbi_platform_ptr(scratch),
+					       extid, funcid, args,
+					       out_val, out_trap);
+	if (ret)
+		return ret;
+
+	/* Vendor calls return two values in a0 and a1 */
+	regs->a0 = out_val[0];
+	regs->a1 = out_val[1];
+	out->regs_updated = TRUE;
+
+	return 0;
 }
 
-int sbi_ecall_base_handler(struct sbi_scratch *scratch,
-			   unsigned long extid, unsigned long funcid,
-			   unsigned long *args, unsigned long *out_val,
-			   struct sbi_trap_info *out_trap)
+static int sbi_ecall_base_handler(struct sbi_scratch *scratch,
+				  unsigned long extid, unsigned long funcid,
+				  struct sbi_trap_regs *regs,
+				  struct sbi_ecall_return *out,
+				  struct sbi_trap_info *out_trap)
 {
 	int ret = 0;
 
 	switch (funcid) {
 	case SBI_EXT_BASE_GET_SPEC_VERSION:
-		*out_val = (SBI_ECALL_VERSION_MAJOR <<
+		out->value = (SBI_ECALL_VERSION_MAJOR <<
 			   SBI_SPEC_VERSION_MAJOR_OFFSET) &
 			   (SBI_SPEC_VERSION_MAJOR_MASK <<
 			    SBI_SPEC_VERSION_MAJOR_OFFSET);
-		*out_val = *out_val | SBI_ECALL_VERSION_MINOR;
+		out->value = out->value | SBI_ECALL_VERSION_MINOR;
 		break;
 	case SBI_EXT_BASE_GET_IMP_ID:
-		*out_val = SBI_OPENSBI_IMPID;
+		out->value = SBI_OPENSBI_IMPID;
 		break;
 	case SBI_EXT_BASE_GET_IMP_VERSION:
-		*out_val = OPENSBI_VERSION;
+		out->value = OPENSBI_VERSION;
 		break;
 	case SBI_EXT_BASE_GET_MVENDORID:
-		*out_val = csr_read(CSR_MVENDORID);
+		out->value = csr_read(CSR_MVENDORID);
 		break;
 	case SBI_EXT_BASE_GET_MARCHID:
-		*out_val = csr_read(CSR_MARCHID);
+		out->value = csr_read(CSR_MARCHID);
 		break;
 	case SBI_EXT_BASE_GET_MIMPID:
-		*out_val = csr_read(CSR_MIMPID);
+		out->value = csr_read(CSR_MIMPID);
 		break;
 	case SBI_EXT_BASE_PROBE_EXT:
-		ret = sbi_check_extension(scratch, args[0], out_val);
+		ret = sbi_check_extension(scratch, regs->a0, &out->value);
 		break;
 	default:
 		ret = SBI_ENOTSUPP;
@@ -116,25 +185,254 @@ int sbi_ecall_base_handler(struct sbi_scratch *scratch,
 	return ret;
 }
 
-int sbi_ecall_0_1_handler(struct sbi_scratch *scratch,
-			  unsigned long extid, unsigned long *args,
-			  struct sbi_trap_info *out_trap)
+static int sbi_ecall_time_handler(struct sbi_scratch *scratch,
+				  unsigned long extid, unsigned long funcid,
+				  struct sbi_trap_regs *regs,
+				  struct sbi_ecall_return *out,
+				  struct sbi_trap_info *out_trap)
+{
+	if (funcid != SBI_EXT_TIME_SET_TIMER)
+		return SBI_ENOTSUPP;
+
+#if __riscv_xlen == 32
+	sbi_timer_event_start(scratch,
+			      (((u64)regs->a1 << 32) | (u64)regs->a0));
+#else
+	sbi_timer_event_start(scratch, (u64)regs->a0);
+#endif
+
+	return 0;
+}
+
+/* Bytes moved per debug console call, a write waits for at most one ring */
+#define SBI_DBCN_MAX_XFER		SBI_CONSOLE_RING_SIZE
+#define SBI_DBCN_CHUNK			64
+
+static int sbi_ecall_dbcn_handler(struct sbi_scratch *scratch,
+				  unsigned long extid, unsigned long funcid,
+				  struct sbi_trap_regs *regs,
+				  struct sbi_ecall_return *out,
+				  struct sbi_trap_info *out_trap)
+{
+	char buf[SBI_DBCN_CHUNK];
+	struct sbi_trap_info trap = { 0 };
+	ulong base = regs->a1, len, done = 0, n, got;
+
+	switch (funcid) {
+	case SBI_EXT_DBCN_CONSOLE_WRITE_BYTE:
+		sbi_putc((char)regs->a0);
+		return 0;
+	case SBI_EXT_DBCN_CONSOLE_WRITE:
+	case SBI_EXT_DBCN_CONSOLE_READ:
+		break;
+	default:
+		return SBI_ENOTSUPP;
+	}
+
+	/* Only addresses reachable by M-mode loads and stores are usable */
+	len = (regs->a0 < SBI_DBCN_MAX_XFER) ? regs->a0 : SBI_DBCN_MAX_XFER;
+	if (regs->a2 || (base + len) < base)
+		return SBI_EINVAL;
+
+	/* The read probe stores buf as is, never leak firmware stack */
+	if (funcid == SBI_EXT_DBCN_CONSOLE_READ)
+		sbi_memset(buf, 0, sizeof(buf));
+
+	while (done < len) {
+		n = len - done;
+		if (n > sizeof(buf))
+			n = sizeof(buf);
+
+		if (funcid == SBI_EXT_DBCN_CONSOLE_WRITE) {
+			got = sbi_load_phys(buf, base + done, n, scratch,
+					    &trap);
+			done += sbi_nputs(buf, got);
+		} else {
+			/*
+			 * Probe the destination first so input is only
+			 * taken from the console once it can be stored.
+			 */
+			n   = sbi_store_phys(base + done, buf, n, scratch,
+					     &trap);
+			n   = sbi_ngets(buf, n);
+			got = sbi_store_phys(base + done, buf, n, scratch,
+					     &trap);
+			done += got;
+			if (!n)
+				break;
+		}
+
+		if (trap.cause)
+			break;
+	}
+
+	if (trap.cause && !done)
+		return SBI_EINVAL;
+
+	out->value = done;
+
+	return 0;
+}
+
+static int sbi_ecall_ipi_handler(struct sbi_scratch *scratch,
+				 unsigned long extid, unsigned long funcid,
+				 struct sbi_trap_regs *regs,
+				 struct sbi_ecall_return *out,
+				 struct sbi_trap_info *out_trap)
+{
+	int ret = 0;
+
+	if (funcid == SBI_EXT_IPI_SEND_IPI)
+		ret = sbi_ipi_send_many(scratch, regs->a0, regs->a1,
+					SBI_IPI_EVENT_SOFT, NULL);
+	else
+		ret = SBI_ENOTSUPP;
+
+	return ret;
+}
+
+static int sbi_ecall_rfence_handler(struct sbi_scratch *scratch,
+				    unsigned long extid, unsigned long funcid,
+				    struct sbi_trap_regs *regs,
+				    struct sbi_ecall_return *out,
+				    struct sbi_trap_info *out_trap)
+{
+	int ret = 0;
+	struct sbi_tlb_info tlb_info;
+	u32 source_hart = sbi_current_hartid();
+
+	SBI_HARTMASK_INIT_EXCEPT(&tlb_info.shart_mask, source_hart);
+
+	/*
+	 * Range based fences take an optional stride hint in a5. It is
+	 * not a standard argument so anything unknown means 4KB.
+	 */
+	tlb_info.stride = 0;
+	if (funcid >= SBI_EXT_RFENCE_REMOTE_SFENCE_VMA &&
+	    funcid <= SBI_EXT_RFENCE_REMOTE_HFENCE_VVMA &&
+	    sbi_tlb_stride_valid(regs->a5))
+		tlb_info.stride = regs->a5;
+
+	if (funcid >= SBI_EXT_RFENCE_REMOTE_HFENCE_GVMA_VMID &&
+	    funcid <= SBI_EXT_RFENCE_REMOTE_HFENCE_VVMA) {
+		if (!misa_extension('H'))
+			return SBI_ENOTSUPP;
+		/* HFENCE.VVMA requests apply to the VMID of calling hart */
+		tlb_info.vmid = (csr_read(CSR_HGATP) & HGATP_VMID_MASK) >>
+				HGATP_VMID_SHIFT;
+	}
+
+	/*
+	 * Hypervisor fences go through the same TLB request queue as
+	 * SFENCE.VMA so they are signaled using the same IPI events.
+	 */
+	switch (funcid) {
+	case SBI_EXT_RFENCE_REMOTE_FENCE_I:
+		tlb_info.start = 0;
+		tlb_info.size  = 0;
+		tlb_info.type  = SBI_ITLB_FLUSH;
+		ret = sbi_ipi_send_many(scratch, regs->a0, regs->a1,
+					SBI_IPI_EVENT_FENCE_I, &tlb_info);
+		break;
+	case SBI_EXT_RFENCE_REMOTE_SFENCE_VMA:
+		tlb_info.start = (unsigned long)regs->a2;
+		tlb_info.size  = (unsigned long)regs->a3;
+		tlb_info.type  = SBI_TLB_FLUSH_VMA;
+		ret = sbi_ipi_send_many(scratch, regs->a0, regs->a1,
+					SBI_IPI_EVENT_SFENCE_VMA, &tlb_info);
+		break;
+	case SBI_EXT_RFENCE_REMOTE_SFENCE_VMA_ASID:
+		tlb_info.start = (unsigned long)regs->a2;
+		tlb_info.size  = (unsigned long)regs->a3;
+		tlb_info.asid  = (unsigned long)regs->a4;
+		tlb_info.type  = SBI_TLB_FLUSH_VMA_ASID;
+		ret = sbi_ipi_send_many(scratch, regs->a0, regs->a1,
+					SBI_IPI_EVENT_SFENCE_VMA_ASID,
+					&tlb_info);
+		break;
+	case SBI_EXT_RFENCE_REMOTE_HFENCE_GVMA_VMID:
+		tlb_info.start = (unsigned long)regs->a2;
+		tlb_info.size  = (unsigned long)regs->a3;
+		tlb_info.vmid  = (unsigned long)regs->a4;
+		tlb_info.type  = SBI_TLB_FLUSH_GVMA_VMID;
+		ret = sbi_ipi_send_many(scratch, regs->a0, regs->a1,
+					SBI_IPI_EVENT_SFENCE_VMA_ASID,
+					&tlb_info);
+		break;
+	case SBI_EXT_RFENCE_REMOTE_HFENCE_GVMA:
+		tlb_info.start = (unsigned long)regs->a2;
+		tlb_info.size  = (unsigned long)regs->a3;
+		tlb_info.type  = SBI_TLB_FLUSH_GVMA;
+		ret = sbi_ipi_send_many(scratch, regs->a0, regs->a1,
+					SBI_IPI_EVENT_SFENCE_VMA, &tlb_info);
+		break;
+	case SBI_EXT_RFENCE_REMOTE_HFENCE_VVMA_ASID:
+		tlb_info.start = (unsigned long)regs->a2;
+		tlb_info.size  = (unsigned long)regs->a3;
+		tlb_info.asid  = (unsigned long)regs->a4;
+		tlb_info.type  = SBI_TLB_FLUSH_VVMA_ASID;
+		ret = sbi_ipi_send_many(scratch, regs->a0, regs->a1,
+					SBI_IPI_EVENT_SFENCE_VMA_ASID,
+					&tlb_info);
+		break;
+	case SBI_EXT_RFENCE_REMOTE_HFENCE_VVMA:
+		tlb_info.start = (unsigned long)regs->a2;
+		tlb_info.size  = (unsigned long)regs->a3;
+		tlb_info.type  = SBI_TLB_FLUSH_VVMA;
+		ret = sbi_ipi_send_many(scratch, regs->a0, regs->a1,
+					SBI_IPI_EVENT_SFENCE_VMA, &tlb_info);
+		break;
+	default:
+		ret = SBI_ENOTSUPP;
+	};
+
+	return ret;
+}
+
+/*
+ * Load the hart mask of a legacy SBI v0.1 call from S-mode memory.
+ * A NULL pointer means all available harts (hart_mask_base = -1UL).
+ */
+static int sbi_load_hart_mask_unpriv(struct sbi_scratch *scratch, ulong *pmask,
+				     ulong *hmask, ulong *hbase,
+				     struct sbi_trap_info *uptrap)
+{
+	if (!pmask) {
+		*hmask = 0;
+		*hbase = -1UL;
+		return 0;
+	}
+
+	*hmask = sbi_load_ulong(pmask, scratch, uptrap);
+	if (uptrap->cause)
+		return SBI_ETRAP;
+	*hbase = 0;
+
+	return 0;
+}
+
+static int sbi_ecall_0_1_call(struct sbi_scratch *scratch,
+			      unsigned long extid, struct sbi_trap_regs *regs,
+			      struct sbi_trap_info *out_trap)
 {
 	int ret = 0;
+	ulong hmask, hbase;
 	struct sbi_tlb_info tlb_info;
 	u32 source_hart = sbi_current_hartid();
 
+	tlb_info.stride = 0;
+
 	switch (extid) {
 	case SBI_EXT_0_1_SET_TIMER:
 #if __riscv_xlen == 32
 		sbi_timer_event_start(scratch,
-				      (((u64)args[1] << 32) | (u64)args[0]));
+				      (((u64)regs->a1 << 32) | (u64)regs->a0));
 #else
-		sbi_timer_event_start(scratch, (u64)args[0]);
+		sbi_timer_event_start(scratch, (u64)regs->a0);
 #endif
 		break;
 	case SBI_EXT_0_1_CONSOLE_PUTCHAR:
-		sbi_putc(args[0]);
+		sbi_putc(regs->a0);
 		break;
 	case SBI_EXT_0_1_CONSOLE_GETCHAR:
 		ret = sbi_getc();
@@ -143,36 +441,50 @@ int sbi_ecall_0_1_handler(struct sbi_scratch *scratch,
 		sbi_ipi_clear_smode(scratch);
 		break;
 	case SBI_EXT_0_1_SEND_IPI:
-		ret = sbi_ipi_send_many(scratch, out_trap, (ulong *)args[0],
-					SBI_IPI_EVENT_SOFT, NULL);
+		ret = sbi_load_hart_mask_unpriv(scratch, (ulong *)regs->a0,
+						&hmask, &hbase, out_trap);
+		if (!ret)
+			ret = sbi_ipi_send_many(scratch, hmask, hbase,
+						SBI_IPI_EVENT_SOFT, NULL);
 		break;
 	case SBI_EXT_0_1_REMOTE_FENCE_I:
 		tlb_info.start  = 0;
 		tlb_info.size  = 0;
 		tlb_info.type  = SBI_ITLB_FLUSH;
-		tlb_info.shart_mask = 1UL << source_hart;
-		ret = sbi_ipi_send_many(scratch, out_trap, (ulong *)args[0],
-					SBI_IPI_EVENT_FENCE_I, &tlb_info);
+		SBI_HARTMASK_INIT_EXCEPT(&tlb_info.shart_mask, source_hart);
+		ret = sbi_load_hart_mask_unpriv(scratch, (ulong *)regs->a0,
+						&hmask, &hbase, out_trap);
+		if (!ret)
+			ret = sbi_ipi_send_many(scratch, hmask, hbase,
+						SBI_IPI_EVENT_FENCE_I,
+						&tlb_info);
 		break;
 	case SBI_EXT_0_1_REMOTE_SFENCE_VMA:
-		tlb_info.start = (unsigned long)args[1];
-		tlb_info.size  = (unsigned long)args[2];
+		tlb_info.start = (unsigned long)regs->a1;
+		tlb_info.size  = (unsigned long)regs->a2;
 		tlb_info.type  = SBI_TLB_FLUSH_VMA;
-		tlb_info.shart_mask = 1UL << source_hart;
+		SBI_HARTMASK_INIT_EXCEPT(&tlb_info.shart_mask, source_hart);
 
-		ret = sbi_ipi_send_many(scratch, out_trap, (ulong *)args[0],
-					SBI_IPI_EVENT_SFENCE_VMA, &tlb_info);
+		ret = sbi_load_hart_mask_unpriv(scratch, (ulong *)regs->a0,
+						&hmask, &hbase, out_trap);
+		if (!ret)
+			ret = sbi_ipi_send_many(scratch, hmask, hbase,
+						SBI_IPI_EVENT_SFENCE_VMA,
+						&tlb_info);
 		break;
 	case SBI_EXT_0_1_REMOTE_SFENCE_VMA_ASID:
-		tlb_info.start = (unsigned long)args[1];
-		tlb_info.size  = (unsigned long)args[2];
-		tlb_info.asid  = (unsigned long)args[3];
+		tlb_info.start = (unsigned long)regs->a1;
+		tlb_info.size  = (unsigned long)regs->a2;
+		tlb_info.asid  = (unsigned long)regs->a3;
 		tlb_info.type  = SBI_TLB_FLUSH_VMA_ASID;
-		tlb_info.shart_mask = 1UL << source_hart;
+		SBI_HARTMASK_INIT_EXCEPT(&tlb_info.shart_mask, source_hart);
 
-		ret = sbi_ipi_send_many(scratch, out_trap, (ulong *)args[0],
-					SBI_IPI_EVENT_SFENCE_VMA_ASID,
-					&tlb_info);
+		ret = sbi_load_hart_mask_unpriv(scratch, (ulong *)regs->a0,
+						&hmask, &hbase, out_trap);
+		if (!ret)
+			ret = sbi_ipi_send_many(scratch, hmask, hbase,
+						SBI_IPI_EVENT_SFENCE_VMA_ASID,
+						&tlb_info);
 		break;
 	case SBI_EXT_0_1_SHUTDOWN:
 		sbi_system_shutdown(scratch, 0);
@@ -184,48 +496,257 @@ int sbi_ecall_0_1_handler(struct sbi_scratch *scratch,
 	return ret;
 }
 
+#ifdef SBI_LOCK_STATS
+static int sbi_ecall_lock_stats_read(unsigned long index, unsigned long stat,
+				     unsigned long *out_val)
+{
+	const struct spinlock_stats *st = spin_lock_stats_get(index);
+
+	if (!st)
+		return SBI_EINVAL;
+
+	switch (stat) {
+	case SBI_FW_DEBUG_LOCK_STAT_ACQUIRED:
+		*out_val = st->acquired;
+		break;
+	case SBI_FW_DEBUG_LOCK_STAT_CONTENDED:
+		*out_val = st->contended;
+		break;
+	case SBI_FW_DEBUG_LOCK_STAT_SPINS:
+		*out_val = st->spins;
+		break;
+	case SBI_FW_DEBUG_LOCK_STAT_MAX_HOLD:
+		*out_val = st->max_hold;
+		break;
+	default:
+		return SBI_EINVAL;
+	}
+
+	return 0;
+}
+#endif
+
+static struct sbi_trap_stats *sbi_ecall_trap_stats(struct sbi_scratch *scratch,
+						   unsigned long hartid)
+{
+	struct sbi_hartmask avail;
+	struct sbi_scratch *rscratch;
+
+	/* Only HARTs which went through sbi_init() have valid statistics */
+	sbi_hart_available_mask(&avail);
+	if (hartid >= SBI_HARTMASK_MAX_BITS ||
+	    !sbi_hartmask_test_hart(hartid, &avail))
+		return NULL;
+
+	rscratch = sbi_hart_id_to_scratch(scratch, hartid);
+	if (!rscratch)
+		return NULL;
+
+	return sbi_trap_stats_ptr(rscratch);
+}
+
+static int sbi_ecall_fw_debug_handler(struct sbi_scratch *scratch,
+				      unsigned long extid, unsigned long funcid,
+				      struct sbi_trap_regs *regs,
+				      struct sbi_ecall_return *out,
+				      struct sbi_trap_info *out_trap)
+{
+	int ret = 0;
+	struct sbi_trap_stats *ts;
+	struct sbi_trap_info trap = { 0 };
+
+	switch (funcid) {
+#ifdef SBI_LOCK_STATS
+	case SBI_EXT_FW_DEBUG_LOCK_STATS_COUNT:
+		out->value = spin_lock_stats_count();
+		break;
+	case SBI_EXT_FW_DEBUG_LOCK_STATS_READ:
+		ret = sbi_ecall_lock_stats_read(regs->a0, regs->a1,
+						&out->value);
+		break;
+	case SBI_EXT_FW_DEBUG_LOCK_STATS_RESET:
+		spin_lock_stats_reset();
+		break;
+	case SBI_EXT_FW_DEBUG_LOCK_STATS_DUMP:
+		spin_lock_stats_dump();
+		break;
+#endif
+	case SBI_EXT_FW_DEBUG_TRAP_STATS_COUNT:
+	case SBI_EXT_FW_DEBUG_TRAP_STATS_CYCLES:
+		ts = sbi_ecall_trap_stats(scratch, regs->a0);
+		if (!ts || regs->a1 >= SBI_FW_DEBUG_TRAP_STAT_MAX)
+			return SBI_EINVAL;
+		if (funcid == SBI_EXT_FW_DEBUG_TRAP_STATS_COUNT)
+			out->value = ts->count[regs->a1];
+		else
+			out->value = ts->cycles[regs->a1];
+		break;
+	case SBI_EXT_FW_DEBUG_TRAP_STATS_RESET:
+		if (!sbi_ecall_trap_stats(scratch, regs->a0))
+			return SBI_EINVAL;
+		sbi_trap_stats_reset(sbi_hart_id_to_scratch(scratch, regs->a0));
+		break;
+	case SBI_EXT_FW_DEBUG_LOG_DRAIN:
+		sbi_log_bin_drain();
+		break;
+	case SBI_EXT_FW_DEBUG_LOG_READ:
+		ret = sbi_log_bin_read(scratch, regs->a0, regs->a1, regs->a2,
+				       &out->value, &trap);
+		break;
+	case SBI_EXT_FW_DEBUG_LOG_DROPPED:
+		out->value = sbi_log_bin_dropped(scratch, regs->a0);
+		break;
+	default:
+		ret = SBI_ENOTSUPP;
+	}
+
+	return ret;
+}
+
+#ifdef WITH_SM
+static int sbi_ecall_sm_handler(struct sbi_scratch *scratch,
+				unsigned long extid, unsigned long funcid,
+				struct sbi_trap_regs *regs,
+				struct sbi_ecall_return *out,
+				struct sbi_trap_info *out_trap)
+{
+	int ret;
+	unsigned long out_val[2] = { 0 };
+
+	ret = sbi_sm_interface(scratch, extid, regs, out_val, out_trap);
+	if (ret == SBI_ETRAP)
+		return ret;
+
+	/*
+	 * The SM returns its own status in a0 and may have switched the
+	 * register state to another context, so a1 is left alone and an
+	 * enclave entry restarts at mepc.
+	 */
+	regs->a0 = out_val[0];
+	if (funcid == SBI_SM_RUN_ENCLAVE)
+		regs->mepc -= 4;
+	out->regs_updated = TRUE;
+
+	return 0;
+}
+#endif
+
+static int sbi_ecall_0_1_handler(struct sbi_scratch *scratch,
+				 unsigned long extid, unsigned long funcid,
+				 struct sbi_trap_regs *regs,
+				 struct sbi_ecall_return *out,
+				 struct sbi_trap_info *out_trap)
+{
+	int ret = sbi_ecall_0_1_call(scratch, extid, regs, out_trap);
+
+	if (ret == SBI_ETRAP)
+		return ret;
+
+	/* Legacy calls only return a0 */
+	regs->a0 = ret;
+	out->regs_updated = TRUE;
+
+	return 0;
+}
+
+static struct sbi_ecall_extension ecall_0_1 = {
+	.extid_start = SBI_EXT_0_1_SET_TIMER,
+	.extid_end = SBI_EXT_0_1_SHUTDOWN,
+	.handle = sbi_ecall_0_1_handler,
+};
+
+static struct sbi_ecall_extension ecall_base = {
+	.extid_start = SBI_EXT_BASE,
+	.extid_end = SBI_EXT_BASE,
+	.handle = sbi_ecall_base_handler,
+};
+
+static struct sbi_ecall_extension ecall_time = {
+	.extid_start = SBI_EXT_TIME,
+	.extid_end = SBI_EXT_TIME,
+	.handle = sbi_ecall_time_handler,
+};
+
+static struct sbi_ecall_extension ecall_ipi = {
+	.extid_start = SBI_EXT_IPI,
+	.extid_end = SBI_EXT_IPI,
+	.handle = sbi_ecall_ipi_handler,
+};
+
+static struct sbi_ecall_extension ecall_rfence = {
+	.extid_start = SBI_EXT_RFENCE,
+	.extid_end = SBI_EXT_RFENCE,
+	.handle = sbi_ecall_rfence_handler,
+};
+
+static struct sbi_ecall_extension ecall_dbcn = {
+	.extid_start = SBI_EXT_DBCN,
+	.extid_end = SBI_EXT_DBCN,
+	.handle = sbi_ecall_dbcn_handler,
+};
+
+static struct sbi_ecall_extension ecall_fw_debug = {
+	.extid_start = SBI_EXT_FW_DEBUG,
+	.extid_end = SBI_EXT_FW_DEBUG,
+	.handle = sbi_ecall_fw_debug_handler,
+};
+
+#ifdef WITH_SM
+static struct sbi_ecall_extension ecall_sm = {
+	.extid_start = SBI_KEYSTONE_SM,
+	.extid_end = SBI_KEYSTONE_SM,
+	.handle = sbi_ecall_sm_handler,
+};
+#endif
+
+static struct sbi_ecall_extension ecall_vendor = {
+	.extid_start = SBI_EXT_VENDOR_START,
+	.extid_end = SBI_EXT_VENDOR_END,
+	.probe = sbi_ecall_vendor_probe,
+	.handle = sbi_ecall_vendor_handler,
+};
+
+int sbi_ecall_init(struct sbi_scratch *scratch)
+{
+	int ret;
+	u32 i;
+	struct sbi_ecall_extension *exts[] = {
+		&ecall_0_1, &ecall_base, &ecall_time, &ecall_ipi,
+		&ecall_rfence, &ecall_dbcn, &ecall_fw_debug,
+#ifdef WITH_SM
+		&ecall_sm,
+#endif
+	};
+
+	for (i = 0; i < sizeof(exts) / sizeof(exts[0]); i++) {
+		ret = sbi_ecall_register_extension(exts[i]);
+		if (ret)
+			return ret;
+	}
+
+	/* The vendor range is only claimed when the platform serves it */
+	if (sbi_platform_ops(sbi_platform_ptr(scratch))->vendor_ext_provider)
+		return sbi_ecall_register_extension(&ecall_vendor);
+
+	return 0;
+}
+
 int sbi_ecall_handler(u32 hartid, ulong mcause, struct sbi_trap_regs *regs,
 		      struct sbi_scratch *scratch)
 {
-	int ret = 0;
+	int ret;
 	unsigned long extension_id = regs->a7;
 	unsigned long func_id = regs->a6;
 	struct sbi_trap_info trap = {0};
-	unsigned long out_val[2];
-	bool is_0_1_spec = 0;
-	unsigned long args[6];
-
-	args[0] = regs->a0;
-	args[1] = regs->a1;
-	args[2] = regs->a2;
-	args[3] = regs->a3;
-	args[4] = regs->a4;
-	args[5] = regs->a5;
-
-	if (extension_id >= SBI_EXT_0_1_SET_TIMER &&
-	    extension_id <= SBI_EXT_0_1_SHUTDOWN) {
-		ret = sbi_ecall_0_1_handler(scratch, extension_id,
-					    args, &trap);
-		is_0_1_spec = 1;
-	} 
-	else if (extension_id == SBI_EXT_BASE) {
-		ret = sbi_ecall_base_handler(scratch, extension_id, func_id,
-					     args, out_val, &trap);
-	} 
-#ifdef WITH_SM
-	else if (extension_id == SBI_KEYSTONE_SM) {
-		ret = sbi_sm_interface(scratch, extension_id, regs, out_val, &trap);
-    } 
-#endif
-	else if (extension_id >= SBI_EXT_VENDOR_START &&
-		extension_id <= SBI_EXT_VENDOR_END) {
-		ret = sbi_ecall_vendor_ext_handler(scratch, extension_id,
-						   func_id, args, out_val,
-						   &trap);
-	} 
-	else {
+	struct sbi_ecall_return out = {0};
+	struct sbi_ecall_extension *ext;
+
+	ext = sbi_ecall_find_extension(extension_id);
+	if (ext)
+		ret = ext->handle(scratch, extension_id, func_id, regs,
+				  &out, &trap);
+	else
 		ret = SBI_ENOTSUPP;
-	}
 
 	if (ret == SBI_ETRAP) {
 		trap.epc = regs->mepc;
@@ -239,28 +760,9 @@ int sbi_ecall_handler(u32 hartid, ulong mcause, struct sbi_trap_regs *regs,
 		 * case should be handled differently.
 		 */
 		regs->mepc += 4;
-		
-		if (is_0_1_spec)
+		if (!out.regs_updated) {
 			regs->a0 = ret;
-		else {
-			if (extension_id == SBI_EXT_BASE)
-			{
-				regs->a0 = ret;
-				regs->a1 = out_val[0];
-			}
-#ifdef WITH_SM
-			else if (extension_id == SBI_KEYSTONE_SM)
-			{
-        regs->a0 = out_val[0];
-
-        if (func_id == SBI_SM_RUN_ENCLAVE)
-          regs->mepc -= 4;
-			}
-#endif
-			else {
-				regs->a0 = out_val[0];
-				regs->a1 = out_val[1];
-			}
+			regs->a1 = out.value;
 		}
 	}
 
@@ -13,6 +13,7 @@
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_emulate_csr.h>
 #include <sbi/sbi_error.h>
+#include <sbi/sbi_log.h>
 #include <sbi/sbi_timer.h>
 #include <sbi/sbi_trap.h>
 
@@ -110,8 +111,8 @@ int sbi_emulate_csr_read(int csr_num, u32 hartid, struct sbi_trap_regs *regs,
 	};
 
 	if (ret)
-		sbi_dprintf(scratch, "%s: hartid%d: invalid csr_num=0x%x\n",
-			    __func__, hartid, csr_num);
+		sbi_log_bin(SBI_LOG_WARN, "%s: invalid csr_num=0x%x\n",
+			    __func__, csr_num);
 
 	return ret;
 }
@@ -178,8 +179,8 @@ int sbi_emulate_csr_write(int csr_num, u32 hartid, struct sbi_trap_regs *regs,
 	};
 
 	if (ret)
-		sbi_dprintf(scratch, "%s: hartid%d: invalid csr_num=0x%x\n",
-			    __func__, hartid, csr_num);
+		sbi_log_bin(SBI_LOG_WARN, "%s: invalid csr_num=0x%x\n",
+			    __func__, csr_num);
 
 	return ret;
 }
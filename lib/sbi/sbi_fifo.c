@@ -7,22 +7,109 @@
  *   Atish Patra<atish.patra@wdc.com>
  *
  */
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_barrier.h>
 #include <sbi/riscv_locks.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_fifo.h>
 #include <sbi/sbi_string.h>
 
+/*
+ * Lock-free MPSC fifo
+ *
+ * Every slot carries a sequence number next to its entry. Producers
+ * reserve a slot by advancing prod_pos with compare-and-swap and then
+ * publish the entry by bumping the slot sequence number, so producers
+ * never serialise on a lock. The single consumer advances cons_pos.
+ *
+ * Positions advance in steps of SBI_FIFO_SEQ_STEP so that bit0 of a
+ * sequence number is free to mark a published slot as claimed, either
+ * by the consumer or by a producer doing an inplace update. For a slot
+ * with position 'pos' the sequence number is:
+ *	pos				- free, can be reserved
+ *	pos + STEP			- published
+ *	pos + STEP + CLAIMED		- published and claimed
+ *	pos + STEP * num_entries	- consumed, free for next round
+ */
+#define SBI_FIFO_SEQ_STEP	2UL
+#define SBI_FIFO_SEQ_CLAIMED	1UL
+
+struct sbi_fifo_slot {
+	volatile unsigned long seq;
+	unsigned long data[];
+};
+
+static inline struct sbi_fifo_slot *__sbi_fifo_slot(struct sbi_fifo *fifo,
+						    unsigned long pos)
+{
+	unsigned long index;
+
+	index = (pos / SBI_FIFO_SEQ_STEP) & (fifo->num_entries - 1);
+
+	return fifo->queue + index * fifo->slot_size;
+}
+
+static inline u16 __sbi_fifo_mpsc_avail(struct sbi_fifo *fifo)
+{
+	unsigned long cons = fifo->cons_pos;
+	unsigned long used = (fifo->prod_pos - cons) / SBI_FIFO_SEQ_STEP;
+
+	return (used < fifo->num_entries) ? used : fifo->num_entries;
+}
+
 void sbi_fifo_init(struct sbi_fifo *fifo, void *queue_mem, u16 entries,
 		   u16 entry_size)
 {
 	fifo->queue	  = queue_mem;
 	fifo->num_entries = entries;
 	fifo->entry_size  = entry_size;
-	SPIN_LOCK_INIT(&fifo->qlock);
+	fifo->slot_size	  = entry_size;
+	fifo->flags	  = 0;
+	SPIN_LOCK_NAMED_INIT(&fifo->qlock, "fifo");
 	fifo->avail = fifo->tail = 0;
+	fifo->prod_pos = fifo->cons_pos = 0;
 	sbi_memset(fifo->queue, 0, (size_t)entries * entry_size);
 }
 
+static void __sbi_fifo_mpsc_reset(struct sbi_fifo *fifo)
+{
+	u16 i;
+	struct sbi_fifo_slot *slot;
+
+	fifo->prod_pos = fifo->cons_pos = 0;
+	sbi_memset(fifo->queue, 0, (size_t)fifo->num_entries * fifo->slot_size);
+	for (i = 0; i < fifo->num_entries; i++) {
+		slot = fifo->queue + (u32)i * fifo->slot_size;
+		slot->seq = i * SBI_FIFO_SEQ_STEP;
+	}
+	smp_wmb();
+}
+
+/**
+ * Initialize a lock-free multi-producer single-consumer fifo.
+ *
+ * The queue memory must be SBI_FIFO_MPSC_MEM_SIZE(entries, entry_size)
+ * bytes and the number of entries must be a power of two. Only one HART
+ * (the owner of the fifo) is allowed to dequeue.
+ */
+int sbi_fifo_init_mpsc(struct sbi_fifo *fifo, void *queue_mem, u16 entries,
+		       u16 entry_size)
+{
+	if (!fifo || !queue_mem || !entries || (entries & (entries - 1)))
+		return SBI_EINVAL;
+
+	fifo->queue	  = queue_mem;
+	fifo->num_entries = entries;
+	fifo->entry_size  = entry_size;
+	fifo->slot_size	  = SBI_FIFO_MPSC_SLOT_SIZE(entry_size);
+	fifo->flags	  = SBI_FIFO_MPSC;
+	SPIN_LOCK_NAMED_INIT(&fifo->qlock, "fifo");
+	fifo->avail = fifo->tail = 0;
+	__sbi_fifo_mpsc_reset(fifo);
+
+	return 0;
+}
+
 /* Note: must be called with fifo->qlock held */
 static inline bool __sbi_fifo_is_full(struct sbi_fifo *fifo)
 {
@@ -36,6 +123,9 @@ u16 sbi_fifo_avail(struct sbi_fifo *fifo)
 	if (!fifo)
 		return 0;
 
+	if (fifo->flags & SBI_FIFO_MPSC)
+		return __sbi_fifo_mpsc_avail(fifo);
+
 	spin_lock(&fifo->qlock);
 	ret = fifo->avail;
 	spin_unlock(&fifo->qlock);
@@ -47,6 +137,10 @@ bool sbi_fifo_is_full(struct sbi_fifo *fifo)
 {
 	bool ret;
 
+	if (fifo->flags & SBI_FIFO_MPSC)
+		return (__sbi_fifo_mpsc_avail(fifo) == fifo->num_entries) ?
+			TRUE : FALSE;
+
 	spin_lock(&fifo->qlock);
 	ret = __sbi_fifo_is_full(fifo);
 	spin_unlock(&fifo->qlock);
@@ -79,6 +173,9 @@ bool sbi_fifo_is_empty(struct sbi_fifo *fifo)
 {
 	bool ret;
 
+	if (fifo->flags & SBI_FIFO_MPSC)
+		return (__sbi_fifo_mpsc_avail(fifo) == 0) ? TRUE : FALSE;
+
 	spin_lock(&fifo->qlock);
 	ret = __sbi_fifo_is_empty(fifo);
 	spin_unlock(&fifo->qlock);
@@ -101,6 +198,12 @@ bool sbi_fifo_reset(struct sbi_fifo *fifo)
 	if (!fifo)
 		return FALSE;
 
+	/* Note: MPSC fifo must not have any producer active at this point */
+	if (fifo->flags & SBI_FIFO_MPSC) {
+		__sbi_fifo_mpsc_reset(fifo);
+		return TRUE;
+	}
+
 	spin_lock(&fifo->qlock);
 	__sbi_fifo_reset(fifo);
 	spin_unlock(&fifo->qlock);
@@ -108,9 +211,48 @@ bool sbi_fifo_reset(struct sbi_fifo *fifo)
 	return TRUE;
 }
 
+static int sbi_fifo_mpsc_inplace_update(struct sbi_fifo *fifo, void *in,
+					int (*fptr)(void *in, void *data))
+{
+	u16 i;
+	int ret = SBI_FIFO_UNCHANGED;
+	unsigned long pos, prod, published;
+	struct sbi_fifo_slot *slot;
+
+	pos  = __smp_load_acquire(&fifo->cons_pos);
+	prod = __smp_load_acquire(&fifo->prod_pos);
+
+	for (i = 0; i < fifo->num_entries && pos != prod;
+	     i++, pos += SBI_FIFO_SEQ_STEP) {
+		slot = __sbi_fifo_slot(fifo, pos);
+		published = pos + SBI_FIFO_SEQ_STEP;
+
+		/*
+		 * Claim the slot so that neither the consumer nor another
+		 * producer can touch the entry. Slots which are already
+		 * consumed, not yet published or claimed by someone else
+		 * are simply skipped.
+		 */
+		if (atomic_raw_cmpxchg_ulong(&slot->seq, published,
+				published | SBI_FIFO_SEQ_CLAIMED) != published)
+			continue;
+
+		ret = fptr(in, slot->data);
+
+		__smp_store_release(&slot->seq, published);
+
+		if (ret == SBI_FIFO_SKIP || ret == SBI_FIFO_UPDATED)
+			break;
+	}
+
+	return ret;
+}
+
 /**
  * Provide a helper function to do inplace update to the fifo.
- * Note: The callback function is called with lock being held.
+ * Note: The callback function is called with lock being held. For
+ * a lock-free MPSC fifo, the callback is called with only the entry
+ * being updated claimed.
  *
  * **Do not** invoke any other fifo function from callback. Otherwise, it will
  * lead to deadlock.
@@ -125,6 +267,9 @@ int sbi_fifo_inplace_update(struct sbi_fifo *fifo, void *in,
 	if (!fifo || !in)
 		return ret;
 
+	if (fifo->flags & SBI_FIFO_MPSC)
+		return sbi_fifo_mpsc_inplace_update(fifo, in, fptr);
+
 	spin_lock(&fifo->qlock);
 
 	if (__sbi_fifo_is_empty(fifo)) {
@@ -148,11 +293,50 @@ int sbi_fifo_inplace_update(struct sbi_fifo *fifo, void *in,
 	return ret;
 }
 
+static int sbi_fifo_mpsc_enqueue(struct sbi_fifo *fifo, void *data)
+{
+	long diff;
+	unsigned long pos, seq, prev;
+	struct sbi_fifo_slot *slot;
+
+	pos = fifo->prod_pos;
+	while (1) {
+		slot = __sbi_fifo_slot(fifo, pos);
+		seq  = __smp_load_acquire(&slot->seq);
+		diff = (long)(seq - pos);
+
+		if (diff == 0) {
+			/* Slot is free so try to reserve it */
+			prev = atomic_raw_cmpxchg_ulong(&fifo->prod_pos, pos,
+						pos + SBI_FIFO_SEQ_STEP);
+			if (prev == pos)
+				break;
+			pos = prev;
+		} else if (diff < 0) {
+			/* Slot not yet consumed in previous round */
+			return SBI_ENOSPC;
+		} else {
+			/* Some other producer got this slot */
+			pos = fifo->prod_pos;
+		}
+	}
+
+	sbi_memcpy(slot->data, data, fifo->entry_size);
+
+	/* Publish the entry to consumer */
+	__smp_store_release(&slot->seq, pos + SBI_FIFO_SEQ_STEP);
+
+	return 0;
+}
+
 int sbi_fifo_enqueue(struct sbi_fifo *fifo, void *data)
 {
 	if (!fifo || !data)
 		return SBI_EINVAL;
 
+	if (fifo->flags & SBI_FIFO_MPSC)
+		return sbi_fifo_mpsc_enqueue(fifo, data);
+
 	spin_lock(&fifo->qlock);
 
 	if (__sbi_fifo_is_full(fifo)) {
@@ -166,11 +350,48 @@ int sbi_fifo_enqueue(struct sbi_fifo *fifo, void *data)
 	return 0;
 }
 
+/* Note: must only be called by the owner (i.e. single consumer) */
+static int sbi_fifo_mpsc_dequeue(struct sbi_fifo *fifo, void *data)
+{
+	unsigned long pos, seq, published;
+	struct sbi_fifo_slot *slot;
+
+	pos = fifo->cons_pos;
+	slot = __sbi_fifo_slot(fifo, pos);
+	published = pos + SBI_FIFO_SEQ_STEP;
+
+	while (1) {
+		seq = __smp_load_acquire(&slot->seq);
+		if (seq == published) {
+			if (atomic_raw_cmpxchg_ulong(&slot->seq, published,
+				published | SBI_FIFO_SEQ_CLAIMED) == published)
+				break;
+		} else if (seq == (published | SBI_FIFO_SEQ_CLAIMED)) {
+			/* A producer is doing inplace update of this entry */
+			cpu_relax();
+		} else {
+			/* Slot is free or reserved but not yet published */
+			return SBI_ENOENT;
+		}
+	}
+
+	sbi_memcpy(data, slot->data, fifo->entry_size);
+
+	__smp_store_release(&fifo->cons_pos, published);
+	__smp_store_release(&slot->seq,
+			    pos + SBI_FIFO_SEQ_STEP * fifo->num_entries);
+
+	return 0;
+}
+
 int sbi_fifo_dequeue(struct sbi_fifo *fifo, void *data)
 {
 	if (!fifo || !data)
 		return SBI_EINVAL;
 
+	if (fifo->flags & SBI_FIFO_MPSC)
+		return sbi_fifo_mpsc_dequeue(fifo, data);
+
 	spin_lock(&fifo->qlock);
 
 	if (__sbi_fifo_is_empty(fifo)) {
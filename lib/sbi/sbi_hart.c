@@ -7,6 +7,8 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
+#define SBI_LOG_SUBSYS		HART
+
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_barrier.h>
 #include <sbi/riscv_encoding.h>
@@ -16,46 +18,10 @@
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_log.h>
 #include <sbi/sbi_platform.h>
 
-#include <sbi/riscv_io.h>
-#define uart_base (volatile void *)0xE0000000
-/* UART base address was defined in plat/serve_X.mk */
-#define UART_TXFIFO_FULL        (1 << UART_TXFIFO_FULL_BIT)
-#define UART_RXFIFO_EMPTY       (1 << UART_RXFIFO_EMPTY_BIT)
-#define UART_RXFIFO_DATA        0x000000ff
-
-
-static inline void set_reg(u32 num, u32 offset)
-{
-        writel(num, uart_base + offset);
-}
-
-static inline u32 get_reg(u32 offset)
-{
-        return readl(uart_base + offset);
-}
-
-
-static void serve_uart_putc(char ch)
-{
-        while (get_reg(UART_REG_CH_STAT) & UART_TXFIFO_FULL)
-                ;
-
-        set_reg(ch, UART_REG_TX_FIFO);
-}
-
-
-static void sbi_Debug_puts(const char *str)
-{
-        while (*str) {
-                serve_uart_putc(*str);
-                str++;
-        }
-}
-
-
-
 /**
  * Return HART ID of the caller.
  */
@@ -238,43 +204,30 @@ static int pmp_init(struct sbi_scratch *scratch, u32 hartid)
 	
 	return 0;
 }
-/*static int pmp_init(struct sbi_scratch *scratch, u32 hartid)
-{
-	sbi_Debug_puts("\n\rskip: pmp_init");
-	return 0;
-}*/
 
 static unsigned long trap_info_offset;
 
 int sbi_hart_init(struct sbi_scratch *scratch, u32 hartid, bool cold_boot)
 {
 	int rc;
-	sbi_Debug_puts("\n\rlib/sbi/sbi_hart.c: sbi_hart_init: sbi_hart_init start:");
+
 	if (cold_boot) {
 		trap_info_offset = sbi_scratch_alloc_offset(__SIZEOF_POINTER__,
 							    "HART_TRAP_INFO");
 		if (!trap_info_offset)
-		{
-			sbi_Debug_puts("\n\r SBI_ENOMEM");
 			return SBI_ENOMEM;
-		}
 	}
-	sbi_Debug_puts("\n\rlib/sbi/sbi_hart.c: sbi_hart_init: into: mstatus_init");
+
 	mstatus_init(scratch, hartid);
-	sbi_Debug_puts("\n\rlib/sbi/sbi_hart.c: sbi_hart_init: into: fp_init");
+
 	rc = fp_init(hartid);
 	if (rc)
-	{
-		sbi_Debug_puts("\n\rfp_init error");
 		return rc;
-	}
-	sbi_Debug_puts("\n\rlib/sbi/sbi_hart.c: sbi_hart_init: into: delegate_traps");
+
 	rc = delegate_traps(scratch, hartid);
 	if (rc)
-	{
-		sbi_Debug_puts("\n\rdelegate_traps error");
 		return rc;
-	}
+
 	return pmp_init(scratch, hartid);
 }
 
@@ -308,6 +261,21 @@ void __attribute__((noreturn)) sbi_hart_hang(void)
 	__builtin_unreachable();
 }
 
+static void sbi_hart_dump_csrs(unsigned long arg0, unsigned long arg1)
+{
+	sbi_printf("HART%lu: next arg0=0x%lx arg1=0x%lx mepc=0x%lx\n",
+		   csr_read(CSR_MHARTID), arg0, arg1, csr_read(CSR_MEPC));
+	sbi_printf("HART%lu: mstatus=0x%lx mie=0x%lx mip=0x%lx\n",
+		   csr_read(CSR_MHARTID), csr_read(CSR_MSTATUS),
+		   csr_read(CSR_MIE), csr_read(CSR_MIP));
+	sbi_printf("HART%lu: mideleg=0x%lx medeleg=0x%lx mcounteren=0x%lx\n",
+		   csr_read(CSR_MHARTID), csr_read(CSR_MIDELEG),
+		   csr_read(CSR_MEDELEG), csr_read(CSR_MCOUNTEREN));
+	sbi_printf("HART%lu: mtvec=0x%lx stvec=0x%lx pmpcfg0=0x%lx\n",
+		   csr_read(CSR_MHARTID), csr_read(CSR_MTVEC),
+		   csr_read(CSR_STVEC), csr_read(CSR_PMPCFG0));
+}
+
 void __attribute__((noreturn))
 sbi_hart_switch_mode(unsigned long arg0, unsigned long arg1,
 		     unsigned long next_addr, unsigned long next_mode,
@@ -318,8 +286,6 @@ sbi_hart_switch_mode(unsigned long arg0, unsigned long arg1,
 #else
 	unsigned long val;
 #endif
-	sbi_printf("\n\rarg0:0x%lx",arg0);
-	sbi_printf("\n\rarg1:0x%lx",arg1);
 	switch (next_mode) {
 	case PRV_M:
 		break;
@@ -371,75 +337,42 @@ sbi_hart_switch_mode(unsigned long arg0, unsigned long arg1,
 		csr_write(CSR_UIE, 0);
 	}
 
-	//register unsigned long a0 asm("a0") = arg0;
-	//register unsigned long a1 asm("a1") = arg1;
-
-	sbi_Debug_puts("\n\rBefore mret, print some CSRs:");
-
-	sbi_printf("\n\rCSR_Read: 0x%lx - CSR_mhartid\n\r",csr_read(CSR_MHARTID));
-
-	sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MSTATUS",csr_read(CSR_MSTATUS));	
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_SSTATUS",csr_read(CSR_SSTATUS));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MSCRATCH",csr_read(CSR_MSCRATCH));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_SSCRATCH",csr_read(CSR_SSCRATCH));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_STVEC",csr_read(CSR_STVEC));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MIE",csr_read(CSR_MIE));
-	sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MIP",csr_read(CSR_MIP));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MISA",csr_read(CSR_MISA));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MTVEC",csr_read(CSR_MTVEC));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_STVEC",csr_read(CSR_STVEC));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MEDELEG",csr_read(CSR_MEDELEG));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MCOUNTEREN",csr_read(CSR_MCOUNTEREN));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_SCOUNTEREN",csr_read(CSR_SCOUNTEREN));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_PMPCFG0",csr_read(CSR_PMPCFG0));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_PMPADDR0",csr_read(CSR_PMPADDR0));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_PMPADDR1",csr_read(CSR_PMPADDR1));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_PMPADDR2",csr_read(CSR_PMPADDR2));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_PMPADDR3",csr_read(CSR_PMPADDR3));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MEPC",csr_read(CSR_MEPC));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MCAUSE",csr_read(CSR_MCAUSE));
-        sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MTVAL",csr_read(CSR_MTVAL));
-
-	for(int i=0;i<50;i++)
-		sbi_printf("\n\r %d",i);        
-	//sbi_printf("\n\ra0:0x%lx",a0);
-	//sbi_printf("\n\ra1:0x%lx",a1);
-	//sbi_printf("\n\rCSR_Read: 0x%lx - 
-	//	sbi_hart_hang();
-	
-        register unsigned long a0 asm("a0") = arg0;
-        register unsigned long a1 asm("a1") = arg1;
+	if (sbi_log_enabled(SBI_LOG_DEBUG))
+		sbi_hart_dump_csrs(arg0, arg1);
 
+	register unsigned long a0 asm("a0") = arg0;
+	register unsigned long a1 asm("a1") = arg1;
 	__asm__ __volatile__("mret" : : "r"(a0), "r"(a1));
 	__builtin_unreachable();
 }
 
-static spinlock_t avail_hart_mask_lock	      = SPIN_LOCK_INITIALIZER;
-static volatile unsigned long avail_hart_mask = 0;
+static seqlock_t avail_hart_mask_lock	      =
+	SEQ_LOCK_NAMED_INITIALIZER("avail_hart_mask");
+static struct sbi_hartmask avail_hart_mask    = { 0 };
 
 void sbi_hart_mark_available(u32 hartid)
 {
-	spin_lock(&avail_hart_mask_lock);
-	avail_hart_mask |= (1UL << hartid);
-	spin_unlock(&avail_hart_mask_lock);
+	write_seqlock(&avail_hart_mask_lock);
+	sbi_hartmask_set_hart(hartid, &avail_hart_mask);
+	write_sequnlock(&avail_hart_mask_lock);
 }
 
 void sbi_hart_unmark_available(u32 hartid)
 {
-	spin_lock(&avail_hart_mask_lock);
-	avail_hart_mask &= ~(1UL << hartid);
-	spin_unlock(&avail_hart_mask_lock);
+	write_seqlock(&avail_hart_mask_lock);
+	sbi_hartmask_clear_hart(hartid, &avail_hart_mask);
+	write_sequnlock(&avail_hart_mask_lock);
 }
 
-ulong sbi_hart_available_mask(void)
+void sbi_hart_available_mask(struct sbi_hartmask *mask)
 {
-	ulong ret;
-
-	spin_lock(&avail_hart_mask_lock);
-	ret = avail_hart_mask;
-	spin_unlock(&avail_hart_mask_lock);
+	unsigned long seq;
 
-	return ret;
+	/* Lockless read, retried only if a HART changed availability */
+	do {
+		seq = read_seqbegin(&avail_hart_mask_lock);
+		sbi_hartmask_copy(mask, &avail_hart_mask);
+	} while (read_seqretry(&avail_hart_mask_lock, seq));
 }
 
 typedef struct sbi_scratch *(*h2s)(ulong hartid);
@@ -450,17 +383,16 @@ struct sbi_scratch *sbi_hart_id_to_scratch(struct sbi_scratch *scratch,
 	return ((h2s)scratch->hartid_to_scratch)(hartid);
 }
 
-#define COLDBOOT_WAIT_BITMAP_SIZE __riscv_xlen
-static spinlock_t coldboot_lock = SPIN_LOCK_INITIALIZER;
+static spinlock_t coldboot_lock = SPIN_LOCK_NAMED_INITIALIZER("coldboot");
 static unsigned long coldboot_done = 0;
-static unsigned long coldboot_wait_bitmap = 0;
+static struct sbi_hartmask coldboot_wait_hmask = { 0 };
 
 void sbi_hart_wait_for_coldboot(struct sbi_scratch *scratch, u32 hartid)
 {
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 
 	if ((sbi_platform_hart_count(plat) <= hartid) ||
-	    (COLDBOOT_WAIT_BITMAP_SIZE <= hartid))
+	    (SBI_HARTMASK_MAX_BITS <= hartid))
 		sbi_hart_hang();
 
 	/* Set MSIE bit to receive IPI */
@@ -470,7 +402,7 @@ void sbi_hart_wait_for_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	spin_lock(&coldboot_lock);
 
 	/* Mark current HART as waiting */
-	coldboot_wait_bitmap |= (1UL << hartid);
+	sbi_hartmask_set_hart(hartid, &coldboot_wait_hmask);
 
 	/* Wait for coldboot to finish using WFI */
 	while (!coldboot_done) {
@@ -480,7 +412,7 @@ void sbi_hart_wait_for_coldboot(struct sbi_scratch *scratch, u32 hartid)
 	};
 
 	/* Unmark current HART as waiting */
-	coldboot_wait_bitmap &= ~(1UL << hartid);
+	sbi_hartmask_clear_hart(hartid, &coldboot_wait_hmask);
 
 	/* Release coldboot lock */
 	spin_unlock(&coldboot_lock);
@@ -492,7 +424,7 @@ void sbi_hart_wait_for_coldboot(struct sbi_scratch *scratch, u32 hartid)
 void sbi_hart_wake_coldboot_harts(struct sbi_scratch *scratch, u32 hartid)
 {
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
-	int max_hart			= sbi_platform_hart_count(plat);
+	struct sbi_hartmask mask;
 
 	/* Acquire coldboot lock */
 	spin_lock(&coldboot_lock);
@@ -501,10 +433,9 @@ void sbi_hart_wake_coldboot_harts(struct sbi_scratch *scratch, u32 hartid)
 	coldboot_done = 1;
 
 	/* Send an IPI to all HARTs waiting for coldboot */
-	for (int i = 0; i < max_hart; i++) {
-		if ((i != hartid) && (coldboot_wait_bitmap & (1UL << i)))
-			sbi_platform_ipi_send(plat, i);
-	}
+	sbi_hartmask_copy(&mask, &coldboot_wait_hmask);
+	sbi_hartmask_clear_hart(hartid, &mask);
+	sbi_platform_ipi_send_hartmask(plat, &mask);
 
 	/* Release coldboot lock */
 	spin_unlock(&coldboot_lock);
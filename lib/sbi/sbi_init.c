@@ -7,15 +7,20 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
+#define SBI_LOG_SUBSYS		INIT
+
 #include <sbi/riscv_asm.h>
 #include <sbi/riscv_atomic.h>
 #include <sbi/sbi_console.h>
 #include <sbi/sbi_ecall.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_ipi.h>
+#include <sbi/sbi_log.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_system.h>
 #include <sbi/sbi_timer.h>
+#include <sbi/sbi_tlb.h>
+#include <sbi/sbi_trap.h>
 #include <sbi/sbi_version.h>
 
 #ifdef WITH_SM
@@ -32,43 +37,6 @@
 	"        | |\n"                                     \
 	"        |_|\n\n"
 
-#include <sbi/riscv_io.h>
-#define uart_base (volatile void *)0xE0000000
-/* UART base address was defined in plat/serve_X.mk */
-#define UART_TXFIFO_FULL        (1 << UART_TXFIFO_FULL_BIT)
-#define UART_RXFIFO_EMPTY       (1 << UART_RXFIFO_EMPTY_BIT)
-#define UART_RXFIFO_DATA        0x000000ff
-
-
-static inline void set_reg(u32 num, u32 offset)
-{
-        writel(num, uart_base + offset);
-}
-
-static inline u32 get_reg(u32 offset)
-{
-        return readl(uart_base + offset);
-}
-
-
-static void serve_uart_putc(char ch)
-{
-        while (get_reg(UART_REG_CH_STAT) & UART_TXFIFO_FULL)
-                ;
-
-        set_reg(ch, UART_REG_TX_FIFO);
-}
-
-
-static void sbi_Debug_puts(const char *str)
-{
-        while (*str) {
-                serve_uart_putc(*str);
-                str++;
-        }
-}
-
-
 static void sbi_boot_prints(struct sbi_scratch *scratch, u32 hartid)
 {
 	int xlen;
@@ -99,6 +67,10 @@ static void sbi_boot_prints(struct sbi_scratch *scratch, u32 hartid)
 	sbi_printf("Platform Max HARTs     : %d\n",
 		   sbi_platform_hart_count(plat));
 	sbi_printf("Current Hart           : %u\n", hartid);
+	sbi_printf("TLB Range Flush Limit  : %lu KB (%s)\n",
+		   sbi_tlb_range_flush_limit() / 1024,
+		   sbi_platform_tlbr_flush_limit(plat) ? "platform" :
+							 "calibrated");
 	/* Firmware details */
 	sbi_printf("Firmware Base          : 0x%lx\n", scratch->fw_start);
 	sbi_printf("Firmware Size          : %d KB\n",
@@ -107,76 +79,85 @@ static void sbi_boot_prints(struct sbi_scratch *scratch, u32 hartid)
 	sbi_printf("Runtime SBI Version    : %d.%d\n",
 		   sbi_ecall_version_major(), sbi_ecall_version_minor());
 	sbi_printf("\n");
-	sbi_printf("\n\rhartid: %d",hartid);
-	sbi_hart_pmp_dump(scratch);
 
+	sbi_hart_pmp_dump(scratch);
 }
 
 static void __noreturn init_coldboot(struct sbi_scratch *scratch, u32 hartid)
 {
 	int rc;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
-	sbi_Debug_puts("\n\rlib/sbi/sbi_init.c: init_coldboot: sbi_system_early_init");
+
 	rc = sbi_system_early_init(scratch, TRUE);
 	if (rc)
-	{
-		sbi_Debug_puts("\n\r rc=1,hang");
 		sbi_hart_hang();
-	}
-	sbi_Debug_puts("\n\rlib/sbi/sbi_init.c: init_coldboot: sbi_hart_init");
+
 	rc = sbi_hart_init(scratch, hartid, TRUE);
 	if (rc)
-	{
-		sbi_Debug_puts("\n\rsbi_hart_init rc=1,hang");
 		sbi_hart_hang();
-	}
-	sbi_Debug_puts("\n\rlib/sbi/sbi_init.c: init_coldboot:  sbi_console_init");
+
+	rc = sbi_trap_stats_init(scratch, TRUE);
+	if (rc)
+		sbi_hart_hang();
+
 	rc = sbi_console_init(scratch);
 	if (rc)
 		sbi_hart_hang();
-	sbi_Debug_puts("\n\rlib/sbi/sbi_init.c: init_coldboot:  sbi_platform_irqchip_init");	
+
+	sbi_log_debug("init: HART%u irqchip\n", hartid);
 	rc = sbi_platform_irqchip_init(plat, TRUE);
 	if (rc)
 		sbi_hart_hang();
-	sbi_Debug_puts("\n\rlib/sbi/sbi_init.c: init_coldboot:  sbi_ipi_init");
+
+	sbi_log_debug("init: HART%u ipi\n", hartid);
 	rc = sbi_ipi_init(scratch, TRUE);
 	if (rc)
 		sbi_hart_hang();
-	sbi_Debug_puts("\n\rlib/sbi/sbi_init.c: init_coldboot(): sbi_timer_init()");
+
+	sbi_log_debug("init: HART%u timer\n", hartid);
 	rc = sbi_timer_init(scratch, TRUE);
 	if (rc)
 		sbi_hart_hang();
-        sbi_Debug_puts("\n\rlib/sbi/sbi_init.c: init_coldboot:  sbi_system_final_init");
+
+	rc = sbi_console_ring_init(scratch, TRUE);
+	if (rc)
+		sbi_hart_hang();
+
+	rc = sbi_console_irq_init(scratch, TRUE);
+	if (rc)
+		sbi_hart_hang();
+
+	rc = sbi_log_bin_init(scratch, TRUE);
+	if (rc)
+		sbi_hart_hang();
+
+	rc = sbi_ecall_init(scratch);
+	if (rc)
+		sbi_hart_hang();
+
+	sbi_log_debug("init: HART%u final\n", hartid);
 	rc = sbi_system_final_init(scratch, TRUE);
 	if (rc)
 		sbi_hart_hang();
-        sbi_Debug_puts("\n\rlib/sbi/sbi_init.c: init_coldboot: sbi_boot_prints");
+
 	if (!(scratch->options & SBI_SCRATCH_NO_BOOT_PRINTS))
 		sbi_boot_prints(scratch, hartid);
-//        sbi_Debug_puts("\n\rinto: init_coldboot: sbi_hart_wake_coldboot_harts");
-//	sbi_printf("\ninto: init_coldboot: sbi_hart_wake_coldboot_harts");
+
 	if (!sbi_platform_has_hart_hotplug(plat))
-	{
-		sbi_Debug_puts("\n\rlib/sbi/sbi_init.c: init_coldboot: sbi_hart_wake_coldboot_harts");
 		sbi_hart_wake_coldboot_harts(scratch, hartid);
-	}
 
 #ifdef WITH_SM
-    sbi_printf("Initializing sm...\r\n");
+	sbi_log_info("Initializing sm...\n");
 	sm_init();
-	sbi_printf("sm init done...\r\n");
+	sbi_log_info("sm init done...\n");
 #endif
 
 	sbi_hart_mark_available(hartid);
-//      sbi_Debug_puts("\n\rinto: init_coldboot:  sbi_hart_switch_mode");
-	sbi_printf("\r\nscratch->next_addr: %lx",scratch->next_addr);
-        sbi_printf("\r\nscratch->next_mode: %lu",scratch->next_mode);
-        sbi_printf("\r\nscratch->next_arg1: %lu",scratch->next_arg1);
-        //sbi_printf("\r\nsbi_hart_hang here...");
-	for (int i=0; i<6; ++i)
-		sbi_printf("\r\n ");
-	//sbi_hart_hang();
-	sbi_printf("\r\n\"hartid\" into sbi_hart_switch_mode() :%x",hartid);	
+
+	sbi_log_debug("init: HART%u next addr=0x%lx mode=%lu arg1=0x%lx\n",
+		      hartid, scratch->next_addr, scratch->next_mode,
+		      scratch->next_arg1);
+	sbi_console_flush();
 	sbi_hart_switch_mode(hartid, scratch->next_arg1, scratch->next_addr,
 			     scratch->next_mode, FALSE);
 }
@@ -185,51 +166,69 @@ static void __noreturn init_warmboot(struct sbi_scratch *scratch, u32 hartid)
 {
 	int rc;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
-        sbi_Debug_puts("\n\rinto: init_warmboot");
+
 	if (!sbi_platform_has_hart_hotplug(plat))
 		sbi_hart_wait_for_coldboot(scratch, hartid);
-	
+
 	if (sbi_platform_hart_disabled(plat, hartid))
 		sbi_hart_hang();
-        sbi_Debug_puts("\n\rinto: init_warmboot: sbi_system_early_init");
+
 	rc = sbi_system_early_init(scratch, FALSE);
 	if (rc)
 		sbi_hart_hang();
-        sbi_Debug_puts("\n\rinto: init_warmboot: sbi_hart_init");
+
 	rc = sbi_hart_init(scratch, hartid, FALSE);
 	if (rc)
 		sbi_hart_hang();
-        sbi_Debug_puts("\n\rinto: init_warmboot: sbi_platform_irqchip_init");
+
+	rc = sbi_trap_stats_init(scratch, FALSE);
+	if (rc)
+		sbi_hart_hang();
+
+	sbi_log_debug("init: HART%u warm irqchip\n", hartid);
 	rc = sbi_platform_irqchip_init(plat, FALSE);
 	if (rc)
 		sbi_hart_hang();
-        sbi_Debug_puts("\n\rinto: init_warmboot: sbi_ipi_init");
+
+	sbi_log_debug("init: HART%u warm ipi\n", hartid);
 	rc = sbi_ipi_init(scratch, FALSE);
 	if (rc)
 		sbi_hart_hang();
-        sbi_Debug_puts("\n\rinto: init_warmboot: sbi_timer_init");
+
+	sbi_log_debug("init: HART%u warm timer\n", hartid);
 	rc = sbi_timer_init(scratch, FALSE);
 	if (rc)
 		sbi_hart_hang();
-        sbi_Debug_puts("\n\rinto: init_warmboot: sbi_system_final_init");
+
+	rc = sbi_console_ring_init(scratch, FALSE);
+	if (rc)
+		sbi_hart_hang();
+
+	rc = sbi_console_irq_init(scratch, FALSE);
+	if (rc)
+		sbi_hart_hang();
+
+	rc = sbi_log_bin_init(scratch, FALSE);
+	if (rc)
+		sbi_hart_hang();
+
 	rc = sbi_system_final_init(scratch, FALSE);
 	if (rc)
 		sbi_hart_hang();
 
 	sbi_hart_mark_available(hartid);
-	
+
 #ifdef WITH_SM
-	sbi_printf("Initializing sm...\r\n");
+	sbi_log_info("Initializing sm...\n");
 	sm_init();
-	sbi_printf("sm init done...\r\n");
+	sbi_log_info("sm init done...\n");
 #endif
 
-	if (sbi_platform_has_hart_hotplug(plat))
+	if (sbi_platform_has_hart_hotplug(plat)) {
 		/* TODO: To be implemented in-future. */
 		sbi_hart_hang();
-	else
-	{
-        	sbi_Debug_puts("\n\rinto: init_warmboot: sbi_hart_switch_mode");
+	} else {
+		sbi_console_flush();
 		sbi_hart_switch_mode(hartid, scratch->next_arg1,
 				     scratch->next_addr,
 				     scratch->next_mode, FALSE);
@@ -255,21 +254,16 @@ void __noreturn sbi_init(struct sbi_scratch *scratch)
 	bool coldboot			= FALSE;
 	u32 hartid			= sbi_current_hartid();
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
-	sbi_Debug_puts("\n\r ----- sbi_init ----- \n\r");
+
 	if (sbi_platform_hart_disabled(plat, hartid))
 		sbi_hart_hang();
 
-	if (atomic_add_return(&coldboot_lottery, 1) == 1)
+	/* Only picks the winner, sbi_hart_wait_for_coldboot() orders the rest */
+	if (atomic_fetch_add_relaxed(&coldboot_lottery, 1) == 0)
 		coldboot = TRUE;
 
 	if (coldboot)
-	{
-		sbi_Debug_puts("\n\rlib/sbi/sbi_init.c: into: init_coldboot ... ");
 		init_coldboot(scratch, hartid);
-	}
 	else
-	{
-                sbi_Debug_puts("\n\rlib/sbi/sbi_init.c: into: init_warmboot ... ");
 		init_warmboot(scratch, hartid);
-	}
 }
@@ -13,11 +13,11 @@
 #include <sbi/riscv_barrier.h>
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_hartmask.h>
 #include <sbi/sbi_ipi.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_tlb.h>
 #include <sbi/sbi_trap.h>
-#include <sbi/sbi_unpriv.h>
 
 #ifdef WITH_SM 
 #include <sm_sbi_opensbi.h>
@@ -25,8 +25,19 @@
 
 static unsigned long ipi_data_off;
 
-static int sbi_ipi_send(struct sbi_scratch *scratch, u32 hartid, u32 event,
-			void *data)
+static inline bool sbi_ipi_event_is_tlb(u32 event)
+{
+	return (event == SBI_IPI_EVENT_SFENCE_VMA ||
+		event == SBI_IPI_EVENT_SFENCE_VMA_ASID ||
+		event == SBI_IPI_EVENT_FENCE_I) ? TRUE : FALSE;
+}
+
+/*
+ * Publish IPI payload and event on the remote hart. The doorbell is
+ * rung separately so that doorbells of many harts can be batched.
+ */
+static int sbi_ipi_publish(struct sbi_scratch *scratch, u32 hartid, u32 event,
+			   void *data)
 {
 	int ret;
 	struct sbi_scratch *remote_scratch = NULL;
@@ -36,57 +47,68 @@ static int sbi_ipi_send(struct sbi_scratch *scratch, u32 hartid, u32 event,
 	if (sbi_platform_hart_disabled(plat, hartid))
 		return -1;
 
-	/*
-	 * Set IPI type on remote hart's scratch area and
-	 * trigger the interrupt
-	 */
+	/* Set IPI type on remote hart's scratch area */
 	remote_scratch = sbi_hart_id_to_scratch(scratch, hartid);
 	ipi_data = sbi_scratch_offset_ptr(remote_scratch, ipi_data_off);
-	if (event == SBI_IPI_EVENT_SFENCE_VMA ||
-	    event == SBI_IPI_EVENT_SFENCE_VMA_ASID ||
-	    event == SBI_IPI_EVENT_FENCE_I ) {
+	if (sbi_ipi_event_is_tlb(event)) {
 		ret = sbi_tlb_fifo_update(remote_scratch, hartid, data);
 		if (ret < 0)
 			return ret;
 	}
-	atomic_raw_set_bit(event, &ipi_data->ipi_type);
-	smp_wmb();
-	sbi_platform_ipi_send(plat, hartid);
-
-	if (event == SBI_IPI_EVENT_SFENCE_VMA ||
-	    event == SBI_IPI_EVENT_SFENCE_VMA_ASID ||
-	    event == SBI_IPI_EVENT_FENCE_I ) {
-		sbi_tlb_fifo_sync(scratch);
-	}
+	/* Publish the event after its data, the doorbell write is ordered */
+	atomic_raw_set_bit_release(event, &ipi_data->ipi_type);
 
 	return 0;
 }
 
-int sbi_ipi_send_many(struct sbi_scratch *scratch,
-		      struct sbi_trap_info *uptrap,
-		      ulong *pmask, u32 event, void *data)
+/**
+ * Send IPI event to a set of harts
+ *
+ * The set of harts is given the same way as the SBI v0.2 hart_mask and
+ * hart_mask_base parameters: bit N of hmask represents hart (hbase + N)
+ * and hbase == -1UL represents all available harts.
+ */
+int sbi_ipi_send_many(struct sbi_scratch *scratch, ulong hmask, ulong hbase,
+		      u32 event, void *data)
 {
-	ulong i, m;
-	ulong mask = sbi_hart_available_mask();
-	u32 hartid = sbi_current_hartid();
+	u32 i, hartid = sbi_current_hartid();
+	struct sbi_hartmask mask, dmask;
+	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
+
+	sbi_hart_available_mask(&mask);
+	if (hbase != -1UL) {
+		SBI_HARTMASK_INIT(&dmask);
+		sbi_hartmask_set_ulong(hmask, hbase, &dmask);
+		sbi_hartmask_and(&mask, &mask, &dmask);
+	}
+	SBI_HARTMASK_INIT(&dmask);
 
-	if (pmask) {
-		mask &= sbi_load_ulong(pmask, scratch, uptrap);
-		if (uptrap->cause)
-			return SBI_ETRAP;
+	/* Publish payloads to every other hart on the set */
+	sbi_hartmask_for_each_hart(i, &mask) {
+		if ((i != hartid) && !sbi_ipi_publish(scratch, i, event, data))
+			sbi_hartmask_set_hart(i, &dmask);
 	}
 
-	/* Send IPIs to every other hart on the set */
-	for (i = 0, m = mask; m; i++, m >>= 1)
-		if ((m & 1UL) && (i != hartid))
-			sbi_ipi_send(scratch, i, event, data);
+	/*
+	 * If the current hart is on the set, publish to
+	 * it as well
+	 */
+	if (sbi_hartmask_test_hart(hartid, &mask) &&
+	    !sbi_ipi_publish(scratch, hartid, event, data))
+		sbi_hartmask_set_hart(hartid, &dmask);
+
+	/* Ring all doorbells in one batch */
+	if (!sbi_hartmask_empty(&dmask)) {
+		smp_wmb();
+		sbi_platform_ipi_send_hartmask(plat, &dmask);
+	}
 
 	/*
-	 * If the current hart is on the set, send an IPI
-	 * to it as well
+	 * Flush requests were queued on all target harts before waiting
+	 * so wait only once for all of them to complete.
 	 */
-	if (mask & (1UL << hartid))
-		sbi_ipi_send(scratch, hartid, event, data);
+	if (sbi_ipi_event_is_tlb(event))
+		sbi_tlb_fifo_sync(scratch);
 
 	return 0;
 }
@@ -107,7 +129,7 @@ void sbi_ipi_process(struct sbi_scratch *scratch)
 	u32 hartid = sbi_current_hartid();
 	sbi_platform_ipi_clear(plat, hartid);
 
-	ipi_type = atomic_raw_xchg_ulong(&ipi_data->ipi_type, 0);
+	ipi_type = atomic_raw_xchg_ulong_acquire(&ipi_data->ipi_type, 0);
 	ipi_event = 0;
 	while (ipi_type) {
 		if (!(ipi_type & 1UL))
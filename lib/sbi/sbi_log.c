@@ -0,0 +1,216 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2019 Western Digital Corporation or its affiliates.
+ */
+
+#include <sbi/riscv_barrier.h>
+#include <sbi/riscv_atomic.h>
+#include <sbi/riscv_locks.h>
+#include <sbi/sbi_console.h>
+#include <sbi/sbi_error.h>
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_hartmask.h>
+#include <sbi/sbi_log.h>
+#include <sbi/sbi_scratch.h>
+#include <sbi/sbi_timer.h>
+#include <sbi/sbi_trap.h>
+#include <sbi/sbi_unpriv.h>
+
+/*
+ * Per-HART binary log ring
+ *
+ * Only the owning HART makes records and advances the tail. Readers on
+ * any HART serialize on log_read_lock and advance the head, so making a
+ * record never takes a lock.
+ */
+struct sbi_log_ring {
+	volatile u32 head;
+	volatile u32 tail;
+	/* Records lost while the ring was full, written by the owner */
+	volatile u32 dropped;
+	/* Value of dropped already reported by sbi_log_bin_drain() */
+	u32 dropped_seen;
+	struct sbi_log_record rec[SBI_LOG_RING_ENTRIES];
+};
+
+#define LOG_RING_MASK		(SBI_LOG_RING_ENTRIES - 1)
+
+static unsigned long log_ring_off;
+static struct sbi_hartmask log_ring_harts = { 0 };
+static spinlock_t log_read_lock = SPIN_LOCK_NAMED_INITIALIZER("log_read");
+
+static struct sbi_log_ring *log_ring_of(struct sbi_scratch *scratch,
+					u32 hartid)
+{
+	struct sbi_scratch *rscratch;
+
+	if (!sbi_hartmask_test_hart(hartid, &log_ring_harts))
+		return NULL;
+
+	rscratch = sbi_hart_id_to_scratch(scratch, hartid);
+	if (!rscratch)
+		return NULL;
+
+	return sbi_scratch_offset_ptr(rscratch, log_ring_off);
+}
+
+void sbi_log_bin_record(const char *fmt, u32 nargs, unsigned long a0,
+			unsigned long a1, unsigned long a2, unsigned long a3)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	u32 hartid = sbi_current_hartid();
+	struct sbi_log_record *rec;
+	struct sbi_log_ring *ring;
+	u32 tail;
+
+	if (!sbi_hartmask_test_hart(hartid, &log_ring_harts))
+		return;
+
+	ring = sbi_scratch_offset_ptr(scratch, log_ring_off);
+	tail = ring->tail;
+	if ((tail - ring->head) >= SBI_LOG_RING_ENTRIES) {
+		ring->dropped++;
+		return;
+	}
+
+	rec	     = &ring->rec[tail & LOG_RING_MASK];
+	rec->fmt     = fmt;
+	rec->time    = sbi_timer_value(scratch);
+	rec->hartid  = hartid;
+	rec->nargs   = nargs;
+	rec->args[0] = a0;
+	rec->args[1] = a1;
+	rec->args[2] = a2;
+	rec->args[3] = a3;
+
+	smp_wmb();
+	ring->tail = tail + 1;
+}
+
+/* Print the records of every HART, called with log_read_lock held */
+static void log_drain_locked(void)
+{
+	struct sbi_scratch *scratch = sbi_scratch_thishart_ptr();
+	struct sbi_log_record *rec;
+	struct sbi_log_ring *ring;
+	u32 hartid, head, dropped;
+
+	sbi_hartmask_for_each_hart(hartid, &log_ring_harts) {
+		ring = log_ring_of(scratch, hartid);
+		if (!ring)
+			continue;
+
+		head = ring->head;
+		smp_rmb();
+		for (; head != ring->tail; head++) {
+			smp_rmb();
+			rec = &ring->rec[head & LOG_RING_MASK];
+			sbi_printf("[%llu] hart%u: ",
+				   (unsigned long long)rec->time, rec->hartid);
+			sbi_printf(rec->fmt, rec->args[0], rec->args[1],
+				   rec->args[2], rec->args[3]);
+		}
+		smp_mb();
+		ring->head = head;
+
+		dropped = ring->dropped;
+		if (dropped != ring->dropped_seen) {
+			sbi_printf("hart%u: %u log records dropped\n", hartid,
+				   dropped - ring->dropped_seen);
+			ring->dropped_seen = dropped;
+		}
+	}
+}
+
+void sbi_log_bin_drain(void)
+{
+	spin_lock(&log_read_lock);
+	log_drain_locked();
+	spin_unlock(&log_read_lock);
+}
+
+void sbi_log_bin_panic(void)
+{
+	/* The fault may have hit while the lock was held */
+	if (!spin_trylock(&log_read_lock))
+		return;
+
+	log_drain_locked();
+	spin_unlock(&log_read_lock);
+}
+
+int sbi_log_bin_read(struct sbi_scratch *scratch, u32 hartid, ulong addr,
+		     ulong len, ulong *out, struct sbi_trap_info *trap)
+{
+	ulong done = 0, size = sizeof(struct sbi_log_record);
+	struct sbi_log_ring *ring;
+	u32 head;
+
+	ring = log_ring_of(scratch, hartid);
+	if (!ring || (addr + len) < addr)
+		return SBI_EINVAL;
+
+	spin_lock(&log_read_lock);
+
+	head = ring->head;
+	smp_rmb();
+	while (head != ring->tail && (len - done) >= size) {
+		smp_rmb();
+		/* A record is only consumed once S-mode has all of it */
+		if (sbi_store_phys(addr + done,
+				   &ring->rec[head & LOG_RING_MASK], size,
+				   scratch, trap) != size)
+			break;
+		done += size;
+		head++;
+	}
+	smp_mb();
+	ring->head = head;
+
+	spin_unlock(&log_read_lock);
+
+	if (trap->cause && !done)
+		return SBI_EINVAL;
+
+	*out = done;
+
+	return 0;
+}
+
+u32 sbi_log_bin_dropped(struct sbi_scratch *scratch, u32 hartid)
+{
+	struct sbi_log_ring *ring = log_ring_of(scratch, hartid);
+
+	return (ring) ? ring->dropped : 0;
+}
+
+int sbi_log_bin_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	struct sbi_log_ring *ring;
+	u32 hartid = sbi_current_hartid();
+
+	if (cold_boot) {
+		log_ring_off = sbi_scratch_alloc_offset(sizeof(*ring),
+							"LOG_RING");
+		if (!log_ring_off)
+			return SBI_ENOMEM;
+	} else {
+		if (!log_ring_off)
+			return SBI_ENOMEM;
+	}
+
+	/* HARTs outside the hartmask drop their records */
+	if (hartid >= SBI_HARTMASK_MAX_BITS)
+		return 0;
+
+	ring		   = sbi_scratch_offset_ptr(scratch, log_ring_off);
+	ring->head	   = 0;
+	ring->tail	   = 0;
+	ring->dropped	   = 0;
+	ring->dropped_seen = 0;
+
+	atomic_raw_set_bit_release(hartid, sbi_hartmask_bits(&log_ring_harts));
+
+	return 0;
+}
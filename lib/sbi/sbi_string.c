@@ -8,8 +8,9 @@
  */
 
 /*
- * Simple libc functions. These are not optimized at all and might have some
- * bugs as well. Use any optimized routines from newlib or glibc if required.
+ * Simple libc functions. Apart from the mem*() routines these are not
+ * optimized at all. Use any optimized routines from newlib or glibc if
+ * required.
  */
 
 #include <sbi/sbi_string.h>
@@ -93,10 +94,41 @@ char *sbi_strrchr(const char *s, int c)
 	else
 		return (char *)last;
 }
+
+/*
+ * The mem*() routines below move XLEN words once both buffers share the
+ * same alignment. OpenSBI is built with -mstrict-align so buffers with
+ * different alignment fall back to bytes unless the compiler reports
+ * that misaligned accesses are fast.
+ */
+#define WORD_SIZE		sizeof(unsigned long)
+#define WORD_MASK		(WORD_SIZE - 1)
+#define WORD_BYTES(__c)		((unsigned long)(__c) * (~0UL / 0xff))
+
+#ifdef __riscv_misaligned_fast
+#define WORDS_ALIGNED(__a, __b)	TRUE
+#else
+#define WORDS_ALIGNED(__a, __b)	\
+	(((unsigned long)(__a) & WORD_MASK) == ((unsigned long)(__b) & WORD_MASK))
+#endif
+
 void *sbi_memset(void *s, int c, size_t count)
 {
 	char *temp = s;
+	unsigned long *wtemp, word = WORD_BYTES(c & 0xff);
+
+	while (count > 0 && ((unsigned long)temp & WORD_MASK)) {
+		count--;
+		*temp++ = c;
+	}
+
+	wtemp = (unsigned long *)temp;
+	while (count >= WORD_SIZE) {
+		count -= WORD_SIZE;
+		*wtemp++ = word;
+	}
 
+	temp = (char *)wtemp;
 	while (count > 0) {
 		count--;
 		*temp++ = c;
@@ -105,41 +137,94 @@ void *sbi_memset(void *s, int c, size_t count)
 	return s;
 }
 
-void *sbi_memcpy(void *dest, const void *src, size_t count)
+/* Ascending copy, also safe for overlapping buffers with dest < src */
+static void copy_forward(char *temp1, const char *temp2, size_t count)
 {
-	char *temp1	  = dest;
-	const char *temp2 = src;
+	unsigned long *wtemp1, w0, w1, w2, w3;
+	const unsigned long *wtemp2;
+
+	if (WORDS_ALIGNED(temp1, temp2)) {
+		while (count > 0 && ((unsigned long)temp1 & WORD_MASK)) {
+			*temp1++ = *temp2++;
+			count--;
+		}
+
+		wtemp1 = (unsigned long *)temp1;
+		wtemp2 = (const unsigned long *)temp2;
+		while (count >= 4 * WORD_SIZE) {
+			w0 = wtemp2[0];
+			w1 = wtemp2[1];
+			w2 = wtemp2[2];
+			w3 = wtemp2[3];
+			wtemp1[0] = w0;
+			wtemp1[1] = w1;
+			wtemp1[2] = w2;
+			wtemp1[3] = w3;
+			wtemp1 += 4;
+			wtemp2 += 4;
+			count -= 4 * WORD_SIZE;
+		}
+		while (count >= WORD_SIZE) {
+			*wtemp1++ = *wtemp2++;
+			count -= WORD_SIZE;
+		}
+
+		temp1 = (char *)wtemp1;
+		temp2 = (const char *)wtemp2;
+	}
 
 	while (count > 0) {
 		*temp1++ = *temp2++;
 		count--;
 	}
-
-	return dest;
 }
 
-void *sbi_memmove(void *dest, const void *src, size_t count)
+/* Descending copy of the count bytes ending at temp1 and temp2 */
+static void copy_backward(char *temp1, const char *temp2, size_t count)
 {
-	char *temp1	  = (char *)dest;
-	const char *temp2 = (char *)src;
-
-	if (src == dest)
-		return dest;
+	unsigned long *wtemp1;
+	const unsigned long *wtemp2;
 
-	if (dest < src) {
-		while (count > 0) {
-			*temp1++ = *temp2++;
+	if (WORDS_ALIGNED(temp1, temp2)) {
+		while (count > 0 && ((unsigned long)temp1 & WORD_MASK)) {
+			*--temp1 = *--temp2;
 			count--;
 		}
-	} else {
-		temp1 = dest + count - 1;
-		temp2 = src + count - 1;
 
-		while (count > 0) {
-			*temp1-- = *temp2--;
-			count--;
+		wtemp1 = (unsigned long *)temp1;
+		wtemp2 = (const unsigned long *)temp2;
+		while (count >= WORD_SIZE) {
+			*--wtemp1 = *--wtemp2;
+			count -= WORD_SIZE;
 		}
+
+		temp1 = (char *)wtemp1;
+		temp2 = (const char *)wtemp2;
+	}
+
+	while (count > 0) {
+		*--temp1 = *--temp2;
+		count--;
 	}
+}
+
+void *sbi_memcpy(void *dest, const void *src, size_t count)
+{
+	copy_forward(dest, src, count);
+
+	return dest;
+}
+
+void *sbi_memmove(void *dest, const void *src, size_t count)
+{
+	if (src == dest)
+		return dest;
+
+	if (dest < src)
+		copy_forward(dest, src, count);
+	else
+		copy_backward((char *)dest + count, (const char *)src + count,
+			      count);
 
 	return dest;
 }
@@ -148,6 +233,28 @@ int sbi_memcmp(const void *s1, const void *s2, size_t count)
 {
 	const char *temp1 = s1;
 	const char *temp2 = s2;
+	const unsigned long *wtemp1, *wtemp2;
+
+	if (WORDS_ALIGNED(temp1, temp2)) {
+		for (; count > 0 && ((unsigned long)temp1 & WORD_MASK) &&
+		       (*temp1 == *temp2); count--) {
+			temp1++;
+			temp2++;
+		}
+
+		/* Skip equal words, the bytes below locate a difference */
+		if (!((unsigned long)temp1 & WORD_MASK)) {
+			wtemp1 = (const unsigned long *)temp1;
+			wtemp2 = (const unsigned long *)temp2;
+			while (count >= WORD_SIZE && *wtemp1 == *wtemp2) {
+				wtemp1++;
+				wtemp2++;
+				count -= WORD_SIZE;
+			}
+			temp1 = (const char *)wtemp1;
+			temp2 = (const char *)wtemp2;
+		}
+	}
 
 	for (; count > 0 && (*temp1 == *temp2); count--) {
 		temp1++;
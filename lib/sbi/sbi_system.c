@@ -8,6 +8,7 @@
  *   Nick Kossifidis <mick@ics.forth.gr>
  */
 
+#include <sbi/sbi_console.h>
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_system.h>
@@ -27,6 +28,7 @@ void __attribute__((noreturn))
 sbi_system_reboot(struct sbi_scratch *scratch, u32 type)
 
 {
+	sbi_console_flush();
 	sbi_platform_system_reboot(sbi_platform_ptr(scratch), type);
 	sbi_hart_hang();
 }
@@ -34,12 +36,14 @@ sbi_system_reboot(struct sbi_scratch *scratch, u32 type)
 void __attribute__((noreturn))
 sbi_system_shutdown(struct sbi_scratch *scratch, u32 type)
 {
+	sbi_console_flush();
+
 	/* First try the platform-specific method */
 	sbi_platform_system_shutdown(sbi_platform_ptr(scratch), type);
 
 	/* If that fails (or is not implemented) send an IPI on every
 	 * hart to hang and then hang the current hart */
-	sbi_ipi_send_many(scratch, NULL, NULL, SBI_IPI_EVENT_HALT, NULL);
+	sbi_ipi_send_many(scratch, 0, -1UL, SBI_IPI_EVENT_HALT, NULL);
 
 	sbi_hart_hang();
 }
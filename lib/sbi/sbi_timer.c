@@ -13,44 +13,25 @@
 #include <sbi/sbi_platform.h>
 #include <sbi/sbi_timer.h>
 
-#include <sbi/riscv_io.h>
-#define uart_base (volatile void *)0xE0000000
-/* UART base address was defined in plat/serve_X.mk */
-#define UART_TXFIFO_FULL        (1 << UART_TXFIFO_FULL_BIT)
-#define UART_RXFIFO_EMPTY       (1 << UART_RXFIFO_EMPTY_BIT)
-#define UART_RXFIFO_DATA        0x000000ff
-
-
-static inline void set_reg(u32 num, u32 offset)
-{
-        writel(num, uart_base + offset);
-}
-
-static inline u32 get_reg(u32 offset)
-{
-        return readl(uart_base + offset);
-}
-
-
-static void serve_uart_putc(char ch)
-{
-        while (get_reg(UART_REG_CH_STAT) & UART_TXFIFO_FULL)
-                ;
-
-        set_reg(ch, UART_REG_TX_FIFO);
-}
-
-
-static void sbi_Debug_puts(const char *str)
-{
-        while (*str) {
-                serve_uart_putc(*str);
-                str++;
-        }
-}
-
-
 static unsigned long time_delta_off;
+static unsigned long time_queue_off;
+
+/*
+ * Per-HART min-heap of pending timer events. The CLINT has a single
+ * comparator per HART so it always holds the earliest deadline of the
+ * heap. One heap slot beyond SBI_TIMER_MAX_EVENTS is reserved for the
+ * S-mode deadline so firmware events can never starve the supervisor.
+ */
+struct sbi_timer_queue {
+	/* Comparator value, valid while armed */
+	u64 programmed;
+	/* Comparator programmed and M-mode timer interrupt enabled */
+	bool armed;
+	u32 count;
+	struct sbi_timer_event *heap[SBI_TIMER_MAX_EVENTS + 1];
+	/* S-mode deadline forwarded by the set_timer calls */
+	struct sbi_timer_event smode;
+};
 
 #if __riscv_xlen == 32
 u64 get_ticks(void)
@@ -113,41 +94,214 @@ void sbi_timer_set_delta_upper(struct sbi_scratch *scratch, ulong delta_upper)
 	*time_delta |= ((u64)delta_upper << 32);
 }
 
+static void timer_heap_swap(struct sbi_timer_queue *tq, u32 i, u32 j)
+{
+	struct sbi_timer_event *ev = tq->heap[i];
+
+	tq->heap[i] = tq->heap[j];
+	tq->heap[j] = ev;
+	tq->heap[i]->slot = i;
+	tq->heap[j]->slot = j;
+}
+
+static void timer_heap_fix(struct sbi_timer_queue *tq, u32 i)
+{
+	u32 parent, child;
+
+	while (i) {
+		parent = (i - 1) / 2;
+		if (tq->heap[parent]->deadline <= tq->heap[i]->deadline)
+			break;
+		timer_heap_swap(tq, parent, i);
+		i = parent;
+	}
+
+	while ((child = 2 * i + 1) < tq->count) {
+		if ((child + 1) < tq->count &&
+		    tq->heap[child + 1]->deadline < tq->heap[child]->deadline)
+			child++;
+		if (tq->heap[i]->deadline <= tq->heap[child]->deadline)
+			break;
+		timer_heap_swap(tq, i, child);
+		i = child;
+	}
+}
+
+static void timer_queue_set(struct sbi_timer_queue *tq,
+			    struct sbi_timer_event *ev, u64 deadline)
+{
+	ev->deadline = deadline;
+	if (!sbi_timer_event_pending(ev)) {
+		ev->slot = tq->count++;
+		tq->heap[ev->slot] = ev;
+	}
+	timer_heap_fix(tq, ev->slot);
+}
+
+static void timer_queue_remove(struct sbi_timer_queue *tq,
+			       struct sbi_timer_event *ev)
+{
+	u32 i = ev->slot;
+
+	ev->slot = SBI_TIMER_EVENT_IDLE;
+	if (i != --tq->count) {
+		tq->heap[i] = tq->heap[tq->count];
+		tq->heap[i]->slot = i;
+		timer_heap_fix(tq, i);
+	}
+}
+
+/* Point the comparator at the earliest pending deadline */
+static void timer_queue_program(struct sbi_scratch *scratch,
+				struct sbi_timer_queue *tq)
+{
+	u64 next;
+
+	if (!tq->count) {
+		if (tq->armed) {
+			tq->armed = FALSE;
+			csr_clear(CSR_MIE, MIP_MTIP);
+		}
+		return;
+	}
+
+	next = tq->heap[0]->deadline;
+	if (tq->armed && tq->programmed == next)
+		return;
+
+	tq->programmed = next;
+	sbi_platform_timer_event_start(sbi_platform_ptr(scratch), next);
+	if (!tq->armed) {
+		tq->armed = TRUE;
+		csr_set(CSR_MIE, MIP_MTIP);
+	}
+}
+
+static void timer_smode_expired(struct sbi_scratch *scratch,
+				struct sbi_timer_event *ev)
+{
+	csr_set(CSR_MIP, MIP_STIP);
+}
+
+int sbi_timer_event_add(struct sbi_scratch *scratch,
+			struct sbi_timer_event *ev, u64 deadline)
+{
+	struct sbi_timer_queue *tq;
+
+	if (!ev || !ev->handler)
+		return SBI_EINVAL;
+
+	tq = sbi_scratch_offset_ptr(scratch, time_queue_off);
+	if (ev == &tq->smode)
+		return SBI_EINVAL;
+	if (!sbi_timer_event_pending(ev) &&
+	    (tq->count - sbi_timer_event_pending(&tq->smode)) >=
+		    SBI_TIMER_MAX_EVENTS)
+		return SBI_ENOSPC;
+
+	timer_queue_set(tq, ev, deadline);
+	timer_queue_program(scratch, tq);
+
+	return 0;
+}
+
+void sbi_timer_event_cancel(struct sbi_scratch *scratch,
+			    struct sbi_timer_event *ev)
+{
+	struct sbi_timer_queue *tq;
+
+	if (!ev || !sbi_timer_event_pending(ev))
+		return;
+
+	tq = sbi_scratch_offset_ptr(scratch, time_queue_off);
+	timer_queue_remove(tq, ev);
+	timer_queue_program(scratch, tq);
+}
+
 void sbi_timer_event_stop(struct sbi_scratch *scratch)
 {
-	sbi_platform_timer_event_stop(sbi_platform_ptr(scratch));
+	struct sbi_timer_queue *tq =
+			sbi_scratch_offset_ptr(scratch, time_queue_off);
+
+	if (sbi_timer_event_pending(&tq->smode))
+		timer_queue_remove(tq, &tq->smode);
+	timer_queue_program(scratch, tq);
+	if (!tq->count)
+		sbi_platform_timer_event_stop(sbi_platform_ptr(scratch));
 }
 
 void sbi_timer_event_start(struct sbi_scratch *scratch, u64 next_event)
 {
-	sbi_platform_timer_event_start(sbi_platform_ptr(scratch), next_event);
-	csr_clear(CSR_MIP, MIP_STIP);
-	csr_set(CSR_MIE, MIP_MTIP);
+	struct sbi_timer_queue *tq =
+			sbi_scratch_offset_ptr(scratch, time_queue_off);
+	struct sbi_timer_event *sev = &tq->smode;
+
+	/*
+	 * While the S-mode deadline is queued its interrupt is clear,
+	 * so repeating it needs neither a heap update nor a device write.
+	 */
+	if (sbi_timer_event_pending(sev)) {
+		if (sev->deadline == next_event)
+			return;
+	} else
+		csr_clear(CSR_MIP, MIP_STIP);
+
+	timer_queue_set(tq, sev, next_event);
+	timer_queue_program(scratch, tq);
 }
 
 void sbi_timer_process(struct sbi_scratch *scratch)
 {
-	csr_clear(CSR_MIE, MIP_MTIP);
-	csr_set(CSR_MIP, MIP_STIP);
+	struct sbi_timer_queue *tq =
+			sbi_scratch_offset_ptr(scratch, time_queue_off);
+	struct sbi_timer_event *ev;
+	u32 budget = tq->count;
+	u64 now = tq->programmed;
+
+	/*
+	 * The comparator firing means every deadline up to the programmed
+	 * one has passed, so expiry needs no timer read. Later deadlines
+	 * already in the past simply fire again once reprogrammed. The
+	 * fired value is kept because handlers re-adding themselves
+	 * reprogram the queue. The budget stops such a handler from
+	 * looping forever.
+	 */
+	while (tq->armed && budget-- && tq->count &&
+	       tq->heap[0]->deadline <= now) {
+		ev = tq->heap[0];
+		timer_queue_remove(tq, ev);
+		ev->handler(scratch, ev);
+	}
+
+	timer_queue_program(scratch, tq);
 }
 
 int sbi_timer_init(struct sbi_scratch *scratch, bool cold_boot)
 {
-	sbi_Debug_puts("\n\rlib/sbi/sbi_timer.c: sbi_timer_init()");
 	u64 *time_delta;
+	struct sbi_timer_queue *tq;
 
 	if (cold_boot) {
 		time_delta_off = sbi_scratch_alloc_offset(sizeof(*time_delta),
 							  "TIME_DELTA");
 		if (!time_delta_off)
 			return SBI_ENOMEM;
+		time_queue_off = sbi_scratch_alloc_offset(sizeof(*tq),
+							  "TIME_QUEUE");
+		if (!time_queue_off)
+			return SBI_ENOMEM;
 	} else {
-		if (!time_delta_off)
+		if (!time_delta_off || !time_queue_off)
 			return SBI_ENOMEM;
 	}
 
 	time_delta = sbi_scratch_offset_ptr(scratch, time_delta_off);
 	*time_delta = 0;
-	sbi_Debug_puts("\n\rlib/sbi/sbi_timer.c: sbi_platform_timer_init(sbi_platform_ptr(scratch), cold_boot);");
+	tq = sbi_scratch_offset_ptr(scratch, time_queue_off);
+	tq->programmed = 0;
+	tq->armed = FALSE;
+	tq->count = 0;
+	sbi_timer_event_init(&tq->smode, timer_smode_expired, NULL);
+
 	return sbi_platform_timer_init(sbi_platform_ptr(scratch), cold_boot);
 }
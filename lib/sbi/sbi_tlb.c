@@ -14,6 +14,9 @@
 #include <sbi/sbi_error.h>
 #include <sbi/sbi_fifo.h>
 #include <sbi/sbi_hart.h>
+#include <sbi/sbi_hfence.h>
+#include <sbi/sbi_ipi.h>
+#include <sbi/sbi_log.h>
 #include <sbi/sbi_scratch.h>
 #include <sbi/sbi_tlb.h>
 #include <sbi/sbi_string.h>
@@ -23,6 +26,7 @@
 static unsigned long tlb_sync_off;
 static unsigned long tlb_fifo_off;
 static unsigned long tlb_fifo_mem_off;
+static unsigned long tlb_waiters_off;
 static unsigned long tlb_range_flush_limit;
 
 static void sbi_tlb_flush_all(void)
@@ -30,18 +34,101 @@ static void sbi_tlb_flush_all(void)
 	__asm__ __volatile("sfence.vma");
 }
 
+/* clang-format off */
+
+#define SBI_TLB_CALIBRATE_PAGES		16
+#define SBI_TLB_CALIBRATE_ROUNDS	4
+#define SBI_TLB_CALIBRATE_MAX_PAGES	512
+
+/* clang-format on */
+
+/*
+ * Measure cost of per-page SFENCE.VMA against a global SFENCE.VMA
+ * using mcycle and return the range size where both cost the same.
+ * The minimum of few rounds is used to filter out interrupts and
+ * cache misses. Refill cost after a global flush is not measured so
+ * the result leans towards range flushes.
+ */
+static unsigned long sbi_tlb_calibrate_flush_limit(void)
+{
+	unsigned long i, r, t, pages;
+	unsigned long page_cost = -1UL, all_cost = -1UL;
+
+	for (r = 0; r < SBI_TLB_CALIBRATE_ROUNDS; r++) {
+		t = csr_read(CSR_MCYCLE);
+		for (i = 0; i < SBI_TLB_CALIBRATE_PAGES; i++)
+			__asm__ __volatile__("sfence.vma %0"
+					     :
+					     : "r"(i * PAGE_SIZE)
+					     : "memory");
+		t = csr_read(CSR_MCYCLE) - t;
+		if (t < page_cost)
+			page_cost = t;
+
+		t = csr_read(CSR_MCYCLE);
+		sbi_tlb_flush_all();
+		t = csr_read(CSR_MCYCLE) - t;
+		if (t < all_cost)
+			all_cost = t;
+	}
+
+	/* No usable mcycle (e.g. inhibited) so use the default */
+	if (!page_cost || !all_cost)
+		return SBI_PLATFORM_TLB_RANGE_FLUSH_LIMIT_DEFAULT;
+
+	pages = (all_cost * SBI_TLB_CALIBRATE_PAGES) / page_cost;
+	if (pages < 1)
+		pages = 1;
+	if (pages > SBI_TLB_CALIBRATE_MAX_PAGES)
+		pages = SBI_TLB_CALIBRATE_MAX_PAGES;
+
+	return pages * PAGE_SIZE;
+}
+
+unsigned long sbi_tlb_range_flush_limit(void)
+{
+	return tlb_range_flush_limit;
+}
+
+/*
+ * Get the flush stride of a request. The stride is a hint from the
+ * caller that the range is mapped with pages of at least that size so
+ * one fence per stride is enough. Start is aligned down to the stride
+ * by the callers.
+ */
+static inline unsigned long __sbi_tlb_stride(struct sbi_tlb_info *tinfo)
+{
+	return (tinfo->stride > PAGE_SIZE) ? tinfo->stride : PAGE_SIZE;
+}
+
+/*
+ * Check whether flushing a range needs more fences than the range
+ * flush limit allows, in which case a full flush is cheaper.
+ */
+static inline bool __sbi_tlb_range_over_limit(unsigned long size,
+					      unsigned long stride)
+{
+	/* A range ending part-way into a stride still needs its fence */
+	unsigned long fences = size / stride + ((size & (stride - 1)) ? 1 : 0);
+
+	return (fences > (tlb_range_flush_limit / PAGE_SIZE)) ? TRUE : FALSE;
+}
+
 static void sbi_tlb_fifo_sfence_vma(struct sbi_tlb_info *tinfo)
 {
 	unsigned long start = tinfo->start;
 	unsigned long size  = tinfo->size;
-	unsigned long i;
+	unsigned long i, stride;
 
 	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
 		sbi_tlb_flush_all();
 		return;
 	}
 
-	for (i = 0; i < size; i += PAGE_SIZE) {
+	stride = __sbi_tlb_stride(tinfo);
+	size += start & (stride - 1);
+	start &= ~(stride - 1);
+	for (i = 0; i < size; i += stride) {
 		__asm__ __volatile__("sfence.vma %0"
 				     :
 				     : "r"(start + i)
@@ -54,7 +141,7 @@ static void sbi_tlb_fifo_sfence_vma_asid(struct sbi_tlb_info *tinfo)
 	unsigned long start = tinfo->start;
 	unsigned long size  = tinfo->size;
 	unsigned long asid  = tinfo->asid;
-	unsigned long i;
+	unsigned long i, stride;
 
 	if (start == 0 && size == 0) {
 		sbi_tlb_flush_all();
@@ -70,7 +157,10 @@ static void sbi_tlb_fifo_sfence_vma_asid(struct sbi_tlb_info *tinfo)
 		return;
 	}
 
-	for (i = 0; i < size; i += PAGE_SIZE) {
+	stride = __sbi_tlb_stride(tinfo);
+	size += start & (stride - 1);
+	start &= ~(stride - 1);
+	for (i = 0; i < size; i += stride) {
 		__asm__ __volatile__("sfence.vma %0, %1"
 				     :
 				     : "r"(start + i), "r"(asid)
@@ -78,17 +168,134 @@ static void sbi_tlb_fifo_sfence_vma_asid(struct sbi_tlb_info *tinfo)
 	}
 }
 
+/*
+ * HFENCE.GVMA takes guest physical address shifted right by 2 so
+ * that it can describe guest physical addresses wider than XLEN.
+ */
+static void sbi_tlb_fifo_hfence_gvma(struct sbi_tlb_info *tinfo)
+{
+	unsigned long start = tinfo->start;
+	unsigned long size  = tinfo->size;
+	unsigned long i, stride;
+
+	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+		__sbi_hfence_gvma_all();
+		return;
+	}
+
+	stride = __sbi_tlb_stride(tinfo);
+	size += start & (stride - 1);
+	start &= ~(stride - 1);
+	for (i = 0; i < size; i += stride)
+		__sbi_hfence_gvma_gpa((start + i) >> 2);
+}
+
+static void sbi_tlb_fifo_hfence_gvma_vmid(struct sbi_tlb_info *tinfo)
+{
+	unsigned long start = tinfo->start;
+	unsigned long size  = tinfo->size;
+	unsigned long vmid  = tinfo->vmid;
+	unsigned long i, stride;
+
+	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+		__sbi_hfence_gvma_vmid(vmid);
+		return;
+	}
+
+	stride = __sbi_tlb_stride(tinfo);
+	size += start & (stride - 1);
+	start &= ~(stride - 1);
+	for (i = 0; i < size; i += stride)
+		__sbi_hfence_gvma_vmid_gpa((start + i) >> 2, vmid);
+}
+
+/*
+ * HFENCE.VVMA applies to the VMID in hgatp so switch hgatp to the
+ * VMID of the requesting hart while doing the flush.
+ */
+static void sbi_tlb_fifo_hfence_vvma(struct sbi_tlb_info *tinfo)
+{
+	unsigned long start = tinfo->start;
+	unsigned long size  = tinfo->size;
+	unsigned long hgatp, i, stride;
+
+	hgatp = csr_swap(CSR_HGATP,
+			 (tinfo->vmid << HGATP_VMID_SHIFT) & HGATP_VMID_MASK);
+
+	if ((start == 0 && size == 0) || (size == SBI_TLB_FLUSH_ALL)) {
+		__sbi_hfence_vvma_all();
+		goto done;
+	}
+
+	stride = __sbi_tlb_stride(tinfo);
+	size += start & (stride - 1);
+	start &= ~(stride - 1);
+	for (i = 0; i < size; i += stride)
+		__sbi_hfence_vvma_va(start + i);
+
+done:
+	csr_write(CSR_HGATP, hgatp);
+}
+
+static void sbi_tlb_fifo_hfence_vvma_asid(struct sbi_tlb_info *tinfo)
+{
+	unsigned long start = tinfo->start;
+	unsigned long size  = tinfo->size;
+	unsigned long asid  = tinfo->asid;
+	unsigned long hgatp, i, stride;
+
+	hgatp = csr_swap(CSR_HGATP,
+			 (tinfo->vmid << HGATP_VMID_SHIFT) & HGATP_VMID_MASK);
+
+	if (start == 0 && size == 0) {
+		__sbi_hfence_vvma_all();
+		goto done;
+	}
+
+	/* Flush entire guest MM context for a given ASID */
+	if (size == SBI_TLB_FLUSH_ALL) {
+		__sbi_hfence_vvma_asid(asid);
+		goto done;
+	}
+
+	stride = __sbi_tlb_stride(tinfo);
+	size += start & (stride - 1);
+	start &= ~(stride - 1);
+	for (i = 0; i < size; i += stride)
+		__sbi_hfence_vvma_asid_va(start + i, asid);
+
+done:
+	csr_write(CSR_HGATP, hgatp);
+}
+
 static void sbi_tlb_local_flush(struct sbi_tlb_info *tinfo)
 {
-	if (tinfo->type == SBI_TLB_FLUSH_VMA) {
+	switch (tinfo->type) {
+	case SBI_TLB_FLUSH_VMA:
 		sbi_tlb_fifo_sfence_vma(tinfo);
-	} else if (tinfo->type == SBI_TLB_FLUSH_VMA_ASID) {
+		break;
+	case SBI_TLB_FLUSH_VMA_ASID:
 		sbi_tlb_fifo_sfence_vma_asid(tinfo);
-	} else if (tinfo->type == SBI_ITLB_FLUSH)
+		break;
+	case SBI_TLB_FLUSH_GVMA:
+		sbi_tlb_fifo_hfence_gvma(tinfo);
+		break;
+	case SBI_TLB_FLUSH_GVMA_VMID:
+		sbi_tlb_fifo_hfence_gvma_vmid(tinfo);
+		break;
+	case SBI_TLB_FLUSH_VVMA:
+		sbi_tlb_fifo_hfence_vvma(tinfo);
+		break;
+	case SBI_TLB_FLUSH_VVMA_ASID:
+		sbi_tlb_fifo_hfence_vvma_asid(tinfo);
+		break;
+	case SBI_ITLB_FLUSH:
 		__asm__ __volatile("fence.i");
-	else
+		break;
+	default:
 		sbi_printf("Invalid tlb flush request type [%lu]\n",
 			   tinfo->type);
+	}
 	return;
 }
 
@@ -96,21 +303,49 @@ static void sbi_tlb_entry_process(struct sbi_scratch *scratch,
 				  struct sbi_tlb_info *tinfo)
 {
 	u32 i;
-	u64 m;
 	struct sbi_scratch *rscratch = NULL;
-	unsigned long *rtlb_sync = NULL;
+	atomic_t *rtlb_sync = NULL;
 
 	sbi_tlb_local_flush(tinfo);
-	for (i = 0, m = tinfo->shart_mask; m; i++, m >>= 1) {
-		if (!(m & 1UL))
-			continue;
 
+	/* Acknowledge completion to every source HART of this entry */
+	sbi_hartmask_for_each_hart(i, &tinfo->shart_mask) {
 		rscratch = sbi_hart_id_to_scratch(scratch, i);
 		rtlb_sync = sbi_scratch_offset_ptr(rscratch, tlb_sync_off);
-		while (atomic_raw_xchg_ulong(rtlb_sync, 1)) ;
+		atomic_fetch_sub_release(rtlb_sync, 1);
 	}
 }
 
+/*
+ * Wake up harts waiting for a free slot in the fifo of current hart.
+ * Must be called after dequeuing entries.
+ */
+static void sbi_tlb_fifo_wake_waiters(struct sbi_scratch *scratch)
+{
+	u32 i;
+	bool wake = FALSE;
+	struct sbi_hartmask wmask;
+	struct sbi_hartmask *waiters =
+			sbi_scratch_offset_ptr(scratch, tlb_waiters_off);
+
+	/* Order freeing of fifo slots before checking for waiters */
+	smp_mb();
+
+	for (i = 0; i < SBI_HARTMASK_WORDS; i++) {
+		wmask.bits[i] = 0;
+		if (!waiters->bits[i])
+			continue;
+		wmask.bits[i] = atomic_raw_xchg_ulong(
+				(volatile unsigned long *)&waiters->bits[i], 0);
+		if (wmask.bits[i])
+			wake = TRUE;
+	}
+
+	if (wake)
+		sbi_platform_ipi_send_hartmask(sbi_platform_ptr(scratch),
+					       &wmask);
+}
+
 static void sbi_tlb_fifo_process_count(struct sbi_scratch *scratch, int count)
 {
 	struct sbi_tlb_info tinfo;
@@ -125,26 +360,79 @@ static void sbi_tlb_fifo_process_count(struct sbi_scratch *scratch, int count)
 			break;
 
 	}
+
+	if (deq_count)
+		sbi_tlb_fifo_wake_waiters(scratch);
 }
 
 void sbi_tlb_fifo_process(struct sbi_scratch *scratch)
 {
 	struct sbi_tlb_info tinfo;
+	u32 deq_count = 0;
 	struct sbi_fifo *tlb_fifo =
 			sbi_scratch_offset_ptr(scratch, tlb_fifo_off);
 
-	while (!sbi_fifo_dequeue(tlb_fifo, &tinfo))
+	while (!sbi_fifo_dequeue(tlb_fifo, &tinfo)) {
 		sbi_tlb_entry_process(scratch, &tinfo);
+		deq_count++;
+	}
+
+	if (deq_count)
+		sbi_tlb_fifo_wake_waiters(scratch);
+}
+
+/*
+ * Wait for a free slot in the fifo of a remote hart.
+ *
+ * The current hart registers itself as waiter of the remote fifo and
+ * sleeps with WFI until the remote hart frees a slot and sends it an
+ * IPI. Own fifo is drained before sleeping and incoming IPIs are
+ * processed after waking up so that two harts enqueuing to each
+ * other's full fifo can not deadlock.
+ */
+static void sbi_tlb_fifo_wait(struct sbi_scratch *lscratch,
+			      struct sbi_scratch *rscratch, u32 curr_hartid)
+{
+	struct sbi_fifo *tlb_fifo_r =
+			sbi_scratch_offset_ptr(rscratch, tlb_fifo_off);
+	struct sbi_hartmask *waiters =
+			sbi_scratch_offset_ptr(rscratch, tlb_waiters_off);
+
+	sbi_tlb_fifo_process(lscratch);
+
+	atomic_raw_set_bit(curr_hartid,
+			   (volatile unsigned long *)sbi_hartmask_bits(waiters));
+
+	/* Slot freed before we registered so don't sleep */
+	if (!sbi_fifo_is_full(tlb_fifo_r)) {
+		atomic_raw_clear_bit(curr_hartid,
+			(volatile unsigned long *)sbi_hartmask_bits(waiters));
+		return;
+	}
+
+	wfi();
+
+	/* Handle wakeup IPI and requests queued on current hart */
+	sbi_ipi_process(lscratch);
 }
 
+/**
+ * Wait until all remote HARTs have completed the flush requests queued
+ * by the current HART.
+ *
+ * Every request queued (or merged into an already queued entry) by
+ * sbi_tlb_fifo_update() increments the pending counter of the source
+ * HART and every remote HART decrements it after doing the flush. This
+ * allows the source HART to queue requests on all remote HARTs, send
+ * all IPIs and then wait only once for all of them.
+ */
 void sbi_tlb_fifo_sync(struct sbi_scratch *scratch)
 {
-	unsigned long *tlb_sync =
-			sbi_scratch_offset_ptr(scratch, tlb_sync_off);
+	atomic_t *tlb_sync = sbi_scratch_offset_ptr(scratch, tlb_sync_off);
 
-	while (!atomic_raw_xchg_ulong(tlb_sync, 0)) {
+	while (atomic_read(tlb_sync) > 0) {
 		/*
-		 * While we are waiting for remote hart to set the sync,
+		 * While we are waiting for remote harts to complete,
 		 * consume fifo requests to avoid deadlock.
 		 */
 		sbi_tlb_fifo_process_count(scratch, 1);
@@ -153,29 +441,137 @@ void sbi_tlb_fifo_sync(struct sbi_scratch *scratch)
 	return;
 }
 
+/*
+ * Number of pending disjoint requests for the same address space after
+ * which the pending request is promoted to flush the whole address
+ * space. Each pending range stays under the range flush limit, so
+ * ranges are worth keeping until one address space would crowd the
+ * others out of the fifo. Two slots are left for other address spaces
+ * and FENCE.I. A full fifo is still handled by collapsing requests.
+ */
+#define SBI_TLB_FIFO_PROMOTE_THRESHOLD		(SBI_TLB_FIFO_NUM_ENTRIES - 2)
+
+struct sbi_tlb_coalesce_ctx {
+	struct sbi_tlb_info *tinfo;
+	u32 match_count;
+};
+
+static inline bool __sbi_tlb_info_is_all(struct sbi_tlb_info *tinfo)
+{
+	return ((tinfo->start == 0 && tinfo->size == 0) ||
+		(tinfo->size == SBI_TLB_FLUSH_ALL)) ? TRUE : FALSE;
+}
+
+static inline void __sbi_tlb_info_merge_mask(struct sbi_tlb_info *curr,
+					     struct sbi_tlb_info *next)
+{
+	sbi_hartmask_or(&curr->shart_mask, &curr->shart_mask,
+			&next->shart_mask);
+}
+
+/* Check whether both requests target the same address space */
+static bool __sbi_tlb_info_same_space(struct sbi_tlb_info *curr,
+				      struct sbi_tlb_info *next)
+{
+	if (next->type != curr->type)
+		return FALSE;
+
+	switch (next->type) {
+	case SBI_TLB_FLUSH_VMA:
+	case SBI_TLB_FLUSH_GVMA:
+	case SBI_ITLB_FLUSH:
+		return TRUE;
+	case SBI_TLB_FLUSH_VMA_ASID:
+		return (next->asid == curr->asid) ? TRUE : FALSE;
+	case SBI_TLB_FLUSH_GVMA_VMID:
+	case SBI_TLB_FLUSH_VVMA:
+		return (next->vmid == curr->vmid) ? TRUE : FALSE;
+	case SBI_TLB_FLUSH_VVMA_ASID:
+		return (next->vmid == curr->vmid &&
+			next->asid == curr->asid) ? TRUE : FALSE;
+	default:
+		return FALSE;
+	}
+}
+
 static inline int __sbi_tlb_fifo_range_check(struct sbi_tlb_info *curr,
 					     struct sbi_tlb_info *next)
 {
 	unsigned long curr_end;
 	unsigned long next_end;
-	int ret = SBI_FIFO_UNCHANGED;
+	unsigned long start, end;
 
 	if (!curr || !next)
-		return ret;
+		return SBI_FIFO_UNCHANGED;
+
+	/*
+	 * A start == 0 and size == 0 request flushes more than any
+	 * other request of the same type so it absorbs everything.
+	 */
+	if (curr->start == 0 && curr->size == 0) {
+		__sbi_tlb_info_merge_mask(curr, next);
+		return SBI_FIFO_SKIP;
+	}
+	if (next->start == 0 && next->size == 0) {
+		curr->start = 0;
+		curr->size  = 0;
+		__sbi_tlb_info_merge_mask(curr, next);
+		return SBI_FIFO_UPDATED;
+	}
+
+	/* Whole address space flush absorbs any range */
+	if (curr->size == SBI_TLB_FLUSH_ALL) {
+		__sbi_tlb_info_merge_mask(curr, next);
+		return SBI_FIFO_SKIP;
+	}
+	if (next->size == SBI_TLB_FLUSH_ALL) {
+		curr->start = 0;
+		curr->size  = SBI_TLB_FLUSH_ALL;
+		__sbi_tlb_info_merge_mask(curr, next);
+		return SBI_FIFO_UPDATED;
+	}
 
 	next_end = next->start + next->size;
 	curr_end = curr->start + curr->size;
-	if (next->start <= curr->start && next_end > curr_end) {
-		curr->start = next->start;
-		curr->size  = next->size;
-		curr->shart_mask = curr->shart_mask | next->shart_mask;
-		ret	    = SBI_FIFO_UPDATED;
-	} else if (next->start >= curr->start && next_end <= curr_end) {
-		curr->shart_mask = curr->shart_mask | next->shart_mask;
-		ret		 = SBI_FIFO_SKIP;
+
+	/* Contained in the current entry */
+	if (next->start >= curr->start && next_end <= curr_end) {
+		/* A smaller stride can push the range over the limit */
+		if (__sbi_tlb_stride(next) < __sbi_tlb_stride(curr)) {
+			curr->stride = next->stride;
+			if (__sbi_tlb_range_over_limit(curr->size,
+						__sbi_tlb_stride(curr))) {
+				curr->start = 0;
+				curr->size  = SBI_TLB_FLUSH_ALL;
+			}
+		}
+		__sbi_tlb_info_merge_mask(curr, next);
+		return SBI_FIFO_SKIP;
 	}
 
-	return ret;
+	/* Disjoint and not adjacent so nothing to merge */
+	if (next->start > curr_end || curr->start > next_end)
+		return SBI_FIFO_UNCHANGED;
+
+	/*
+	 * Overlapping or adjacent so grow current entry to the union
+	 * using the smaller stride of both.
+	 */
+	if (__sbi_tlb_stride(next) < __sbi_tlb_stride(curr))
+		curr->stride = next->stride;
+	start = (next->start < curr->start) ? next->start : curr->start;
+	end   = (next_end > curr_end) ? next_end : curr_end;
+	if ((end < start) ||
+	    __sbi_tlb_range_over_limit(end - start, __sbi_tlb_stride(curr))) {
+		curr->start = 0;
+		curr->size  = SBI_TLB_FLUSH_ALL;
+	} else {
+		curr->start = start;
+		curr->size  = end - start;
+	}
+	__sbi_tlb_info_merge_mask(curr, next);
+
+	return SBI_FIFO_UPDATED;
 }
 
 /**
@@ -186,18 +582,28 @@ static inline int __sbi_tlb_fifo_range_check(struct sbi_tlb_info *curr,
  *	if next flush request range lies within one of the existing entry, skip
  *	the next entry.
  * Case2:
- *	if flush request range in current fifo entry lies within next flush
- *	request, update the current entry.
+ *	if flush request range in current fifo entry overlaps with or is
+ *	adjacent to next flush request, grow the current entry to the union
+ *	of both ranges. The union is upgraded to flush the whole address
+ *	space if it is bigger than the range flush limit.
+ * Case3:
+ *	if too many requests are pending for the same address space, promote
+ *	the current entry to flush the whole address space.
+ * Case4:
+ *	if both are FENCE.I requests, skip the next entry.
+ *
+ * Range based cases only apply to requests of the same type which also
+ * match on the address space identifiers used by that type (ASID for
+ * SFENCE.VMA.ASID, VMID for HFENCE.GVMA.VMID and HFENCE.VVMA, both for
+ * HFENCE.VVMA.ASID).
  *
  * Note:
  *	We can not issue a fifo reset anymore if a complete vma flush is requested.
  *	This is because we are queueing FENCE.I requests as well now.
- *	To ease up the pressure in enqueue/fifo sync path, try to dequeue 1 element
- *	before continuing the while loop. This method is preferred over wfi/ipi because
- *	of MMIO cost involved in later method.
  */
 static int sbi_tlb_fifo_update_cb(void *in, void *data)
 {
+	struct sbi_tlb_coalesce_ctx *ctx;
 	struct sbi_tlb_info *curr;
 	struct sbi_tlb_info *next;
 	int ret = SBI_FIFO_UNCHANGED;
@@ -206,34 +612,106 @@ static int sbi_tlb_fifo_update_cb(void *in, void *data)
 		return ret;
 
 	curr = (struct sbi_tlb_info *)data;
-	next = (struct sbi_tlb_info *)in;
+	ctx  = (struct sbi_tlb_coalesce_ctx *)in;
+	next = ctx->tinfo;
 
-	if (next->type == SBI_TLB_FLUSH_VMA_ASID &&
-	    curr->type == SBI_TLB_FLUSH_VMA_ASID) {
-		if (next->asid == curr->asid)
-			ret = __sbi_tlb_fifo_range_check(curr, next);
-	} else if (next->type == SBI_TLB_FLUSH_VMA &&
-		   curr->type == SBI_TLB_FLUSH_VMA) {
-			ret = __sbi_tlb_fifo_range_check(curr, next);
+	if (!__sbi_tlb_info_same_space(curr, next))
+		return ret;
+
+	if (next->type == SBI_ITLB_FLUSH) {
+		/* One pending FENCE.I covers any number of requests */
+		__sbi_tlb_info_merge_mask(curr, next);
+		return SBI_FIFO_SKIP;
+	}
+
+	ret = __sbi_tlb_fifo_range_check(curr, next);
+	if (ret != SBI_FIFO_UNCHANGED)
+		return ret;
+
+	if (++ctx->match_count >= SBI_TLB_FIFO_PROMOTE_THRESHOLD) {
+		curr->start = 0;
+		curr->size  = SBI_TLB_FLUSH_ALL;
+		__sbi_tlb_info_merge_mask(curr, next);
+		ret = SBI_FIFO_UPDATED;
 	}
 
 	return ret;
 }
 
+/**
+ * Call back used when the fifo is full to collapse the next request
+ * into a pending request which flushes a superset of both:
+ *	SFENCE.VMA and SFENCE.VMA.ASID into a global SFENCE.VMA
+ *	HFENCE.GVMA and HFENCE.GVMA.VMID into a global HFENCE.GVMA
+ *	HFENCE.VVMA and HFENCE.VVMA.ASID of a VMID into HFENCE.VVMA
+ *	of that VMID
+ */
+static int sbi_tlb_fifo_collapse_cb(void *in, void *data)
+{
+	struct sbi_tlb_info *curr = data;
+	struct sbi_tlb_info *next = in;
+	unsigned long type;
+
+	if (!in || !data)
+		return SBI_FIFO_UNCHANGED;
+
+	switch (next->type) {
+	case SBI_TLB_FLUSH_VMA:
+	case SBI_TLB_FLUSH_VMA_ASID:
+		if (curr->type != SBI_TLB_FLUSH_VMA &&
+		    curr->type != SBI_TLB_FLUSH_VMA_ASID)
+			return SBI_FIFO_UNCHANGED;
+		type = SBI_TLB_FLUSH_VMA;
+		break;
+	case SBI_TLB_FLUSH_GVMA:
+	case SBI_TLB_FLUSH_GVMA_VMID:
+		if (curr->type != SBI_TLB_FLUSH_GVMA &&
+		    curr->type != SBI_TLB_FLUSH_GVMA_VMID)
+			return SBI_FIFO_UNCHANGED;
+		type = SBI_TLB_FLUSH_GVMA;
+		break;
+	case SBI_TLB_FLUSH_VVMA:
+	case SBI_TLB_FLUSH_VVMA_ASID:
+		if ((curr->type != SBI_TLB_FLUSH_VVMA &&
+		     curr->type != SBI_TLB_FLUSH_VVMA_ASID) ||
+		    curr->vmid != next->vmid)
+			return SBI_FIFO_UNCHANGED;
+		type = SBI_TLB_FLUSH_VVMA;
+		break;
+	case SBI_ITLB_FLUSH:
+		if (curr->type != SBI_ITLB_FLUSH)
+			return SBI_FIFO_UNCHANGED;
+		type = SBI_ITLB_FLUSH;
+		break;
+	default:
+		return SBI_FIFO_UNCHANGED;
+	}
+
+	curr->type  = type;
+	curr->start = 0;
+	curr->size  = 0;
+	__sbi_tlb_info_merge_mask(curr, next);
+
+	return SBI_FIFO_SKIP;
+}
+
 int sbi_tlb_fifo_update(struct sbi_scratch *rscratch, u32 hartid, void *data)
 {
 	int ret;
 	struct sbi_fifo *tlb_fifo_r;
 	struct sbi_scratch *lscratch;
+	atomic_t *tlb_sync;
+	struct sbi_tlb_coalesce_ctx ctx;
 	struct sbi_tlb_info *tinfo = data;
 	u32 curr_hartid = sbi_current_hartid();
 
 	/*
 	 * If address range to flush is too big then simply
 	 * upgrade it to flush all because we can only flush
-	 * 4KB at a time.
+	 * one stride (4KB by default) at a time.
 	 */
-	if (tinfo->size > tlb_range_flush_limit) {
+	if (tinfo->size != SBI_TLB_FLUSH_ALL &&
+	    __sbi_tlb_range_over_limit(tinfo->size, __sbi_tlb_stride(tinfo))) {
 		tinfo->start = 0;
 		tinfo->size = SBI_TLB_FLUSH_ALL;
 	}
@@ -249,24 +727,36 @@ int sbi_tlb_fifo_update(struct sbi_scratch *rscratch, u32 hartid, void *data)
 
 	lscratch = sbi_hart_id_to_scratch(rscratch, curr_hartid);
 	tlb_fifo_r = sbi_scratch_offset_ptr(rscratch, tlb_fifo_off);
+	tlb_sync = sbi_scratch_offset_ptr(lscratch, tlb_sync_off);
 
-	ret = sbi_fifo_inplace_update(tlb_fifo_r, data, sbi_tlb_fifo_update_cb);
+	/*
+	 * Account the pending acknowledgement before the request becomes
+	 * visible to the remote hart so that the counter never drops
+	 * below zero. Publishing the request is a release so a relaxed
+	 * increment is enough.
+	 */
+	atomic_fetch_add_relaxed(tlb_sync, 1);
+
+	ctx.tinfo = tinfo;
+	ctx.match_count = 0;
+	ret = sbi_fifo_inplace_update(tlb_fifo_r, &ctx, sbi_tlb_fifo_update_cb);
 	if (ret != SBI_FIFO_UNCHANGED) {
 		return 1;
 	}
 
 	while (sbi_fifo_enqueue(tlb_fifo_r, data) < 0) {
-		/**
-		 * For now, Busy loop until there is space in the fifo.
-		 * There may be case where target hart is also
-		 * enqueue in source hart's fifo. Both hart may busy
-		 * loop leading to a deadlock.
-		 * TODO: Introduce a wait/wakeup event mechanism to handle
-		 * this properly.
+		/*
+		 * Fifo is full so collapse the request into a pending
+		 * request which flushes a superset of both.
 		 */
-		sbi_tlb_fifo_process_count(lscratch, 1);
-		sbi_dprintf(rscratch, "hart%d: hart%d tlb fifo full\n",
-			    curr_hartid, hartid);
+		ret = sbi_fifo_inplace_update(tlb_fifo_r, data,
+					      sbi_tlb_fifo_collapse_cb);
+		if (ret != SBI_FIFO_UNCHANGED)
+			return 1;
+
+		/* Nothing to collapse into so wait for a free slot */
+		sbi_log_bin(SBI_LOG_INFO, "tlb fifo of hart%u full\n", hartid);
+		sbi_tlb_fifo_wait(lscratch, rscratch, curr_hartid);
 	}
 
 	return 0;
@@ -275,8 +765,9 @@ int sbi_tlb_fifo_update(struct sbi_scratch *rscratch, u32 hartid, void *data)
 int sbi_tlb_fifo_init(struct sbi_scratch *scratch, bool cold_boot)
 {
 	void *tlb_mem;
-	unsigned long *tlb_sync;
+	atomic_t *tlb_sync;
 	struct sbi_fifo *tlb_q;
+	struct sbi_hartmask *tlb_waiters;
 	const struct sbi_platform *plat = sbi_platform_ptr(scratch);
 
 	if (cold_boot) {
@@ -291,29 +782,41 @@ int sbi_tlb_fifo_init(struct sbi_scratch *scratch, bool cold_boot)
 			return SBI_ENOMEM;
 		}
 		tlb_fifo_mem_off = sbi_scratch_alloc_offset(
-				SBI_TLB_FIFO_NUM_ENTRIES * SBI_TLB_INFO_SIZE,
+				SBI_FIFO_MPSC_MEM_SIZE(SBI_TLB_FIFO_NUM_ENTRIES,
+						       SBI_TLB_INFO_SIZE),
 				"IPI_TLB_FIFO_MEM");
 		if (!tlb_fifo_mem_off) {
 			sbi_scratch_free_offset(tlb_fifo_off);
 			sbi_scratch_free_offset(tlb_sync_off);
 			return SBI_ENOMEM;
 		}
+		tlb_waiters_off = sbi_scratch_alloc_offset(sizeof(*tlb_waiters),
+							   "IPI_TLB_WAITERS");
+		if (!tlb_waiters_off) {
+			sbi_scratch_free_offset(tlb_fifo_mem_off);
+			sbi_scratch_free_offset(tlb_fifo_off);
+			sbi_scratch_free_offset(tlb_sync_off);
+			return SBI_ENOMEM;
+		}
 		tlb_range_flush_limit = sbi_platform_tlbr_flush_limit(plat);
+		if (!tlb_range_flush_limit)
+			tlb_range_flush_limit = sbi_tlb_calibrate_flush_limit();
 	} else {
 		if (!tlb_sync_off ||
 		    !tlb_fifo_off ||
-		    !tlb_fifo_mem_off)
+		    !tlb_fifo_mem_off ||
+		    !tlb_waiters_off)
 			return SBI_ENOMEM;
 	}
 
 	tlb_sync = sbi_scratch_offset_ptr(scratch, tlb_sync_off);
 	tlb_q = sbi_scratch_offset_ptr(scratch, tlb_fifo_off);
 	tlb_mem = sbi_scratch_offset_ptr(scratch, tlb_fifo_mem_off);
+	tlb_waiters = sbi_scratch_offset_ptr(scratch, tlb_waiters_off);
 
-	*tlb_sync = 0;
+	ATOMIC_INIT(tlb_sync, 0);
+	SBI_HARTMASK_INIT(tlb_waiters);
 
-	sbi_fifo_init(tlb_q, tlb_mem,
-		      SBI_TLB_FIFO_NUM_ENTRIES, SBI_TLB_INFO_SIZE);
-
-	return 0;
+	return sbi_fifo_init_mpsc(tlb_q, tlb_mem,
+				  SBI_TLB_FIFO_NUM_ENTRIES, SBI_TLB_INFO_SIZE);
 }
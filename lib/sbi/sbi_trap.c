@@ -15,7 +15,9 @@
 #include <sbi/sbi_hart.h>
 #include <sbi/sbi_illegal_insn.h>
 #include <sbi/sbi_ipi.h>
+#include <sbi/sbi_log.h>
 #include <sbi/sbi_misaligned_ldst.h>
+#include <sbi/sbi_scratch.h>
 #include <sbi/sbi_timer.h>
 #include <sbi/sbi_trap.h>
 
@@ -23,6 +25,7 @@ static void __noreturn sbi_trap_error(const char *msg, int rc, u32 hartid,
 				      ulong mcause, ulong mtval,
 				      struct sbi_trap_regs *regs)
 {
+	sbi_console_panic();
 	sbi_printf("%s: hart%d: %s (error %d)\n", __func__, hartid, msg, rc);
 	sbi_printf("%s: hart%d: mcause=0x%" PRILX " mtval=0x%" PRILX "\n",
 		   __func__, hartid, mcause, mtval);
@@ -61,6 +64,9 @@ static void __noreturn sbi_trap_error(const char *msg, int rc, u32 hartid,
 	sbi_printf("%s: hart%d: %s=0x%" PRILX "\n", __func__, hartid, "t6",
 		   regs->t6);
 
+	/* Records leading up to the error */
+	sbi_log_bin_panic();
+
 	sbi_hart_hang();
 }
 
@@ -194,6 +200,69 @@ int sbi_trap_redirect(struct sbi_trap_regs *regs,
 	return 0;
 }
 
+static unsigned long trap_stats_off;
+
+struct sbi_trap_stats *sbi_trap_stats_ptr(struct sbi_scratch *scratch)
+{
+	if (!trap_stats_off)
+		return NULL;
+
+	return sbi_scratch_offset_ptr(scratch, trap_stats_off);
+}
+
+void sbi_trap_stats_reset(struct sbi_scratch *scratch)
+{
+	u32 i;
+	struct sbi_trap_stats *ts = sbi_trap_stats_ptr(scratch);
+
+	if (!ts)
+		return;
+
+	for (i = 0; i < SBI_FW_DEBUG_TRAP_STAT_MAX; i++) {
+		ts->count[i]  = 0;
+		ts->cycles[i] = 0;
+	}
+}
+
+int sbi_trap_stats_init(struct sbi_scratch *scratch, bool cold_boot)
+{
+	if (cold_boot) {
+		trap_stats_off = sbi_scratch_alloc_offset(
+					sizeof(struct sbi_trap_stats),
+					"TRAP_STATS");
+		if (!trap_stats_off)
+			return SBI_ENOMEM;
+	} else {
+		if (!trap_stats_off)
+			return SBI_ENOMEM;
+	}
+
+	sbi_trap_stats_reset(scratch);
+
+	return 0;
+}
+
+/*
+ * The cycles of a trap run from the mcycle read by the trap entry code
+ * (passed as start) to the mcycle read by the trap exit code right
+ * before mret, which adds it to the count given in regs->stat_cycles.
+ */
+static inline void sbi_trap_stats_account(struct sbi_scratch *scratch,
+					  struct sbi_trap_regs *regs,
+					  u32 stat, ulong start)
+{
+	struct sbi_trap_stats *ts;
+
+	/* Traps taken before sbi_trap_stats_init() are not accounted */
+	if (!trap_stats_off)
+		return;
+
+	ts = sbi_scratch_offset_ptr(scratch, trap_stats_off);
+	ts->count[stat]++;
+	ts->cycles[stat] -= start;
+	regs->stat_cycles = (unsigned long)&ts->cycles[stat];
+}
+
 /**
  * Handle trap/interrupt
  *
@@ -205,6 +274,8 @@ int sbi_trap_redirect(struct sbi_trap_regs *regs,
  * 3. The 'mtval' CSR is having additional trap information
  * 4. Stack pointer (SP) is setup for current HART
  * 5. Interrupts are disabled in MSTATUS CSR
+ * 6. The 'mcycle' member of register state has mcycle at trap entry
+ *    and the trap exit adds mcycle to the 'stat_cycles' member
  *
  * @param regs pointer to register state
  * @param scratch pointer to sbi_scratch of current HART
@@ -212,8 +283,11 @@ int sbi_trap_redirect(struct sbi_trap_regs *regs,
 void sbi_trap_handler(struct sbi_trap_regs *regs,
 		      struct sbi_scratch *scratch)
 {
+	/* Read before any handler can rewrite the register state */
+	ulong start = regs->mcycle;
 	int rc = SBI_ENOTSUPP;
 	const char *msg = "trap handler failed";
+	u32 stat = SBI_FW_DEBUG_TRAP_STAT_REDIRECT;
 	u32 hartid = sbi_current_hartid();
 	ulong mcause = csr_read(CSR_MCAUSE);
 	ulong mtval = csr_read(CSR_MTVAL);
@@ -224,14 +298,25 @@ void sbi_trap_handler(struct sbi_trap_regs *regs,
 		switch (mcause) {
 		case IRQ_M_TIMER:
 			sbi_timer_process(scratch);
+			stat = SBI_FW_DEBUG_TRAP_STAT_TIMER_IRQ;
 			break;
 		case IRQ_M_SOFT:
 			sbi_ipi_process(scratch);
+			stat = SBI_FW_DEBUG_TRAP_STAT_SOFT_IRQ;
+			break;
+		case IRQ_M_EXT:
+			rc = sbi_console_irq_process(scratch);
+			if (rc) {
+				msg = "unhandled external interrupt";
+				goto trap_error;
+			}
+			stat = SBI_FW_DEBUG_TRAP_STAT_EXT_IRQ;
 			break;
 		default:
 			msg = "unhandled external interrupt";
 			goto trap_error;
 		};
+		sbi_trap_stats_account(scratch, regs, stat, start);
 		return;
 	}
 
@@ -239,20 +324,24 @@ void sbi_trap_handler(struct sbi_trap_regs *regs,
 	case CAUSE_ILLEGAL_INSTRUCTION:
 		rc  = sbi_illegal_insn_handler(hartid, mcause, regs, scratch);
 		msg = "illegal instruction handler failed";
+		stat = SBI_FW_DEBUG_TRAP_STAT_ILLEGAL_INSN;
 		break;
 	case CAUSE_MISALIGNED_LOAD:
 		rc = sbi_misaligned_load_handler(hartid, mcause, regs, scratch);
 		msg = "misaligned load handler failed";
+		stat = SBI_FW_DEBUG_TRAP_STAT_MISALIGNED_LOAD;
 		break;
 	case CAUSE_MISALIGNED_STORE:
 		rc  = sbi_misaligned_store_handler(hartid, mcause, regs,
 						   scratch);
 		msg = "misaligned store handler failed";
+		stat = SBI_FW_DEBUG_TRAP_STAT_MISALIGNED_STORE;
 		break;
 	case CAUSE_SUPERVISOR_ECALL:
 	case CAUSE_HYPERVISOR_ECALL:
 		rc  = sbi_ecall_handler(hartid, mcause, regs, scratch);
 		msg = "ecall handler failed";
+		stat = SBI_FW_DEBUG_TRAP_STAT_ECALL;
 		break;
 	case CAUSE_LOAD_ACCESS:
 	case CAUSE_STORE_ACCESS:
@@ -272,6 +361,7 @@ void sbi_trap_handler(struct sbi_trap_regs *regs,
 			rc = sbi_trap_redirect(regs, &trap, scratch);
 		}
 		msg = "page/access fault handler failed";
+		stat = SBI_FW_DEBUG_TRAP_STAT_ACCESS_FAULT;
 		break;
 	default:
 		/* If the trap came from S or U mode, redirect it there */
@@ -282,9 +372,56 @@ void sbi_trap_handler(struct sbi_trap_regs *regs,
 		break;
 	};
 
+	sbi_trap_stats_account(scratch, regs, stat, start);
+
 trap_error:
 	if (rc) {
 		sbi_trap_error(msg, rc, hartid, mcause, csr_read(CSR_MTVAL),
 			       regs);
 	}
 }
+
+/**
+ * Handle frequent traps without the full register file
+ *
+ * This function is called by firmware linked to OpenSBI library
+ * for timer interrupts, set_timer (legacy and TIME extension) and
+ * the legacy clear_ipi call.
+ * Only the caller-saved registers, the 'mepc' CSR and the trap
+ * statistics members are valid in the register state so it must
+ * not be passed to other handlers.
+ *
+ * @param regs pointer to partial register state
+ * @param scratch pointer to sbi_scratch of current HART
+ */
+void sbi_trap_handler_fast(struct sbi_trap_regs *regs,
+			   struct sbi_scratch *scratch)
+{
+	ulong start = regs->mcycle;
+
+	if (csr_read(CSR_MCAUSE) & (1UL << (__riscv_xlen - 1))) {
+		sbi_timer_process(scratch);
+		sbi_trap_stats_account(scratch, regs,
+				       SBI_FW_DEBUG_TRAP_STAT_TIMER_IRQ, start);
+		return;
+	}
+
+	if (regs->a7 == SBI_EXT_0_1_CLEAR_IPI) {
+		sbi_ipi_clear_smode(scratch);
+	} else {
+#if __riscv_xlen == 32
+		sbi_timer_event_start(scratch,
+				      (((u64)regs->a1 << 32) | (u64)regs->a0));
+#else
+		sbi_timer_event_start(scratch, (u64)regs->a0);
+#endif
+		/* TIME extension returns a value in a1 too */
+		if (regs->a7 == SBI_EXT_TIME)
+			regs->a1 = 0;
+	}
+
+	regs->a0 = 0;
+	regs->mepc += 4;
+	sbi_trap_stats_account(scratch, regs, SBI_FW_DEBUG_TRAP_STAT_ECALL,
+			       start);
+}
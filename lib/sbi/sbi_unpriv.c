@@ -7,6 +7,7 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
+#include <sbi/riscv_asm.h>
 #include <sbi/riscv_encoding.h>
 #include <sbi/sbi_bits.h>
 #include <sbi/sbi_hart.h>
@@ -169,3 +170,58 @@ ulong sbi_get_insn(ulong mepc, struct sbi_scratch *scratch,
 
 	return val;
 }
+
+ulong sbi_load_phys(void *dst, ulong src, ulong len,
+		    struct sbi_scratch *scratch, struct sbi_trap_info *trap)
+{
+	u32 j;
+	ulong i = 0, word, satp;
+	u8 *out = dst;
+
+	trap->cause = 0;
+	satp = csr_swap(CSR_SATP, 0);
+
+	while (i < len) {
+		/* Whole words where aligned, never a misaligned access */
+		if (!((src + i) & (sizeof(ulong) - 1)) &&
+		    sizeof(ulong) <= (len - i)) {
+			word = sbi_load_ulong((const ulong *)(src + i),
+					      scratch, trap);
+			if (trap->cause)
+				break;
+			for (j = 0; j < sizeof(ulong); j++)
+				out[i + j] = (u8)(word >> (8 * j));
+			i += sizeof(ulong);
+		} else {
+			out[i] = sbi_load_u8((const u8 *)(src + i),
+					     scratch, trap);
+			if (trap->cause)
+				break;
+			i++;
+		}
+	}
+
+	csr_write(CSR_SATP, satp);
+
+	return i;
+}
+
+ulong sbi_store_phys(ulong dst, const void *src, ulong len,
+		     struct sbi_scratch *scratch, struct sbi_trap_info *trap)
+{
+	ulong i, satp;
+	const u8 *in = src;
+
+	trap->cause = 0;
+	satp = csr_swap(CSR_SATP, 0);
+
+	for (i = 0; i < len; i++) {
+		sbi_store_u8((u8 *)(dst + i), in[i], scratch, trap);
+		if (trap->cause)
+			break;
+	}
+
+	csr_write(CSR_SATP, satp);
+
+	return i;
+}
@@ -21,12 +21,16 @@
 #define PLIC_ENABLE_STRIDE 0x80
 #define PLIC_CONTEXT_BASE 0x200000
 #define PLIC_CONTEXT_STRIDE 0x1000
+#define PLIC_CONTEXT_CLAIM 0x4
+
+/* Lowest priority above the M-mode threshold of plic_warm_irqchip_init() */
+#define PLIC_M_MODE_PRIORITY 2
 
 static u32 plic_hart_count;
 static u32 plic_num_sources;
 static volatile void *plic_base;
 
-static void plic_set_priority(u32 source, u32 val)
+void plic_set_priority(u32 source, u32 val)
 {
 	volatile void *plic_priority =
 		plic_base + PLIC_PRIORITY_BASE + 4 * source;
@@ -47,6 +51,38 @@ void plic_set_ie(u32 cntxid, u32 word_index, u32 val)
 	writel(val, plic_ie + word_index * 4);
 }
 
+u32 plic_claim(u32 cntxid)
+{
+	volatile void *plic_claim = plic_base + PLIC_CONTEXT_BASE +
+				    PLIC_CONTEXT_STRIDE * cntxid +
+				    PLIC_CONTEXT_CLAIM;
+	return readl(plic_claim);
+}
+
+void plic_complete(u32 cntxid, u32 source)
+{
+	volatile void *plic_claim = plic_base + PLIC_CONTEXT_BASE +
+				    PLIC_CONTEXT_STRIDE * cntxid +
+				    PLIC_CONTEXT_CLAIM;
+	writel(source, plic_claim);
+}
+
+int plic_mmode_enable(u32 m_cntx_id, u32 source)
+{
+	volatile void *plic_ie;
+
+	if (!source || plic_num_sources < source)
+		return -1;
+
+	plic_ie = plic_base + PLIC_ENABLE_BASE +
+		  PLIC_ENABLE_STRIDE * m_cntx_id + (source / 32) * 4;
+
+	plic_set_priority(source, PLIC_M_MODE_PRIORITY);
+	writel(readl(plic_ie) | (1U << (source % 32)), plic_ie);
+
+	return 0;
+}
+
 void plic_fdt_fixup(void *fdt, const char *compat)
 {
 	u32 *cells;
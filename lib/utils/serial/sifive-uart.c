@@ -25,7 +25,12 @@
 #define UART_RXFIFO_EMPTY	0x80000000
 #define UART_RXFIFO_DATA	0x000000ff
 #define UART_TXCTRL_TXEN	0x1
+#define UART_TXCTRL_TXCNT(x)	(((x) & 0x7) << 16)
+#define UART_IP_TXWM		0x1
+
+#define UART_TX_FIFO_DEPTH	8
 #define UART_RXCTRL_RXEN	0x1
+#define UART_IE_RXWM		0x2
 
 /* clang-format on */
 
@@ -74,6 +79,42 @@ void sifive_uart_putc(char ch)
 	set_reg(UART_REG_TXFIFO, ch);
 }
 
+int sifive_uart_try_putc(char ch)
+{
+	if (get_reg(UART_REG_TXFIFO) & UART_TXFIFO_FULL)
+		return -1;
+
+	set_reg(UART_REG_TXFIFO, ch);
+	return 0;
+}
+
+int sifive_uart_puts(const char *str, size_t len)
+{
+	size_t i = 0;
+
+	/* The watermark is set to one entry so it is pending only when empty */
+	if (get_reg(UART_REG_IP) & UART_IP_TXWM) {
+		for (; i < len && i < UART_TX_FIFO_DEPTH; i++)
+			set_reg(UART_REG_TXFIFO, str[i]);
+		return i;
+	}
+
+	/* Partly filled FIFO, only the full flag tells if there is room */
+	for (; i < len; i++) {
+		if (get_reg(UART_REG_TXFIFO) & UART_TXFIFO_FULL)
+			break;
+		set_reg(UART_REG_TXFIFO, str[i]);
+	}
+
+	return i;
+}
+
+void sifive_uart_rx_irq_enable(void)
+{
+	/* The RX watermark is zero so any received byte raises it */
+	set_reg(UART_REG_IE, UART_IE_RXWM);
+}
+
 int sifive_uart_getc(void)
 {
 	u32 ret = get_reg(UART_REG_RXFIFO);
@@ -92,8 +133,8 @@ int sifive_uart_init(unsigned long base, u32 in_freq, u32 baudrate)
 	set_reg(UART_REG_DIV, uart_min_clk_divisor(in_freq, baudrate));
 	/* Disable interrupts */
 	set_reg(UART_REG_IE, 0);
-	/* Enable TX */
-	set_reg(UART_REG_TXCTRL, UART_TXCTRL_TXEN);
+	/* Enable TX, watermark pending while the TX FIFO is empty */
+	set_reg(UART_REG_TXCTRL, UART_TXCTRL_TXEN | UART_TXCTRL_TXCNT(1));
 	/* Enable Rx */
 	set_reg(UART_REG_RXCTRL, UART_RXCTRL_RXEN);
 
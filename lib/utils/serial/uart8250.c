@@ -36,6 +36,12 @@
 #define UART_LSR_DR		0x01    /* Receiver data ready */
 #define UART_LSR_BRK_ERROR_BITS	0x1E    /* BI, FE, PE, OE bits */
 
+#define UART_IER_RDI		0x01    /* Enable receiver data interrupt */
+
+#define UART_IIR_FIFO_ENABLED	0xC0    /* FIFOs enabled and working */
+
+#define UART_TX_FIFO_DEPTH	16	/* 16550A transmit FIFO */
+
 /* clang-format on */
 
 static volatile void *uart8250_base;
@@ -43,6 +49,7 @@ static u32 uart8250_in_freq;
 static u32 uart8250_baudrate;
 static u32 uart8250_reg_width;
 static u32 uart8250_reg_shift;
+static u32 uart8250_tx_fifo_depth = 1;
 
 static u32 get_reg(u32 num)
 {
@@ -76,6 +83,36 @@ void uart8250_putc(char ch)
 	set_reg(UART_THR_OFFSET, ch);
 }
 
+int uart8250_try_putc(char ch)
+{
+	if ((get_reg(UART_LSR_OFFSET) & UART_LSR_THRE) == 0)
+		return -1;
+
+	set_reg(UART_THR_OFFSET, ch);
+	return 0;
+}
+
+int uart8250_puts(const char *str, size_t len)
+{
+	size_t i;
+
+	/* With FIFOs enabled THRE means the whole transmit FIFO is free */
+	if ((get_reg(UART_LSR_OFFSET) & UART_LSR_THRE) == 0)
+		return 0;
+
+	if (len > uart8250_tx_fifo_depth)
+		len = uart8250_tx_fifo_depth;
+	for (i = 0; i < len; i++)
+		set_reg(UART_THR_OFFSET, str[i]);
+
+	return len;
+}
+
+void uart8250_rx_irq_enable(void)
+{
+	set_reg(UART_IER_OFFSET, UART_IER_RDI);
+}
+
 int uart8250_getc(void)
 {
 	if (get_reg(UART_LSR_OFFSET) & UART_LSR_DR)
@@ -108,6 +145,12 @@ int uart8250_init(unsigned long base, u32 in_freq, u32 baudrate, u32 reg_shift,
 	set_reg(UART_LCR_OFFSET, 0x03);
 	/* Enable FIFO */
 	set_reg(UART_FCR_OFFSET, 0x01);
+	/* Plain 8250 and 16550 parts only buffer a single byte */
+	if ((get_reg(UART_IIR_OFFSET) & UART_IIR_FIFO_ENABLED) ==
+	    UART_IIR_FIFO_ENABLED)
+		uart8250_tx_fifo_depth = UART_TX_FIFO_DEPTH;
+	else
+		uart8250_tx_fifo_depth = 1;
 	/* No modem control DTR RTS */
 	set_reg(UART_MCR_OFFSET, 0x00);
 	/* Clear line status */
@@ -7,50 +7,15 @@
  *   Anup Patel <anup.patel@wdc.com>
  */
 
-#include <sbi/riscv_io.h>
-#include <sbi/riscv_atomic.h>
-#include <sbi/sbi_hart.h>
-#include <sbi_utils/sys/clint.h>
+#define SBI_LOG_SUBSYS		CLINT
 
-#include <sbi/sbi_console.h>
 #include <sbi/riscv_asm.h>
+#include <sbi/riscv_atomic.h>
 #include <sbi/riscv_encoding.h>
 #include <sbi/riscv_io.h>
-#define uart_base (volatile void *)0xE0000000
-/* UART base address was defined in plat/serve_X.mk */
-#define UART_TXFIFO_FULL        (1 << UART_TXFIFO_FULL_BIT)
-#define UART_RXFIFO_EMPTY       (1 << UART_RXFIFO_EMPTY_BIT)
-#define UART_RXFIFO_DATA        0x000000ff
-
-
-static inline void set_reg(u32 num, u32 offset)
-{
-        writel(num, uart_base + offset);
-}
-
-static inline u32 get_reg(u32 offset)
-{
-        return readl(uart_base + offset);
-}
-
-
-static void serve_uart_putc(char ch)
-{
-        while (get_reg(UART_REG_CH_STAT) & UART_TXFIFO_FULL)
-                ;
-
-        set_reg(ch, UART_REG_TX_FIFO);
-}
-
-
-static void sbi_Debug_puts(const char *str)
-{
-        while (*str) {
-                serve_uart_putc(*str);
-                str++;
-        }
-}
-
+#include <sbi/sbi_hart.h>
+#include <sbi/sbi_log.h>
+#include <sbi_utils/sys/clint.h>
 
 static u32 clint_ipi_hart_count;
 static volatile void *clint_ipi_base;
@@ -65,6 +30,26 @@ void clint_ipi_send(u32 target_hart)
 	writel(1, &clint_ipi[target_hart]);
 }
 
+void clint_ipi_send_mask(ulong mask, ulong base)
+{
+	ulong i;
+
+	/*
+	 * Order prior memory writes (IPI payloads) before the doorbells
+	 * once and then ring all doorbells back-to-back.
+	 */
+	RISCV_FENCE(w, o);
+	for (i = 0; mask; i++, mask >>= 1) {
+		if (!(mask & 1UL))
+			continue;
+		if (clint_ipi_hart_count <= (base + i))
+			break;
+
+		/* Set CLINT IPI */
+		__raw_writel(1, &clint_ipi[base + i]);
+	}
+}
+
 void clint_ipi_clear(u32 target_hart)
 {
 	if (clint_ipi_hart_count <= target_hart)
@@ -125,7 +110,6 @@ u64 clint_timer_value(void)
 
 void clint_timer_event_stop(void)
 {
-	sbi_Debug_puts("\n\rlib/utils/sys/clint.c: into clint_timer_event_stop()");
 	u32 target_hart = sbi_current_hartid();
 
 	if (clint_time_hart_count <= target_hart)
@@ -138,12 +122,10 @@ void clint_timer_event_stop(void)
 	writel_relaxed(-1UL, &clint_time_cmp[target_hart]);
 	writel_relaxed(-1UL, (void *)(&clint_time_cmp[target_hart]) + 0x04);
 #endif
-	sbi_Debug_puts("\n\rlib/utils/sys/clint.c: done clint_timer_event_stop()");
 }
 
 void clint_timer_event_start(u64 next_event)
 {
-	sbi_Debug_puts("\n\rlib/utils/sys/clint.c: into clint_timer_event_start()");
 	u32 target_hart = sbi_current_hartid();
 
 	if (clint_time_hart_count <= target_hart)
@@ -158,13 +140,10 @@ void clint_timer_event_start(u64 next_event)
 	writel_relaxed(next_event >> 32,
 		       (void *)(&clint_time_cmp[target_hart]) + 0x04);
 #endif
-	sbi_Debug_puts("\n\rlib/utils/sys/clint.c: done clint_timer_event_start()");
-
 }
 
 int clint_warm_timer_init(void)
 {
-	sbi_Debug_puts("\n\rlib/utils/sys/clint.c: into clint_warm_timer_init()");
 	u32 target_hart = sbi_current_hartid();
 
 	if (clint_time_hart_count <= target_hart || !clint_time_base)
@@ -177,22 +156,17 @@ int clint_warm_timer_init(void)
 	writel_relaxed(-1UL, &clint_time_cmp[target_hart]);
 	writel_relaxed(-1UL, (void *)(&clint_time_cmp[target_hart]) + 0x04);
 #endif
-	sbi_printf("\n\rtarget_hart: %u",target_hart);
-	sbi_printf("\n\rclint_time_cmp[%u]: %lx",target_hart,clint_time_cmp[target_hart]);
-	sbi_printf("\n\rCSR_Read: 0x%lx - CSR_MIP",csr_read(CSR_MIP));
-
-	sbi_printf("\n\rWaiting for CSR_MIP clear ...");
-	while(csr_read(CSR_MIP))
-	{
-		sbi_printf("\n\rclint_time_val(mtime):%lx",readq_relaxed(clint_time_val));
-	}
-	sbi_printf("\n\rlib/utils/sys/clint.c: Done Clear CLINT Time Compare");
+
+	/* The cleared comparator may take a while to drop MIP.MTIP */
+	while (csr_read(CSR_MIP) & MIP_MTIP)
+		;
+	sbi_log_debug("clint: HART%u comparator cleared\n", target_hart);
+
 	return 0;
 }
 
 int clint_cold_timer_init(unsigned long base, u32 hart_count)
 {
-	sbi_Debug_puts("\n\rlib/utils/sys/clint.c: into clint_cold_timer_init()");
 	/* Figure-out CLINT Time register address */
 	clint_time_hart_count = hart_count;
 	clint_time_base	      = (void *)base;
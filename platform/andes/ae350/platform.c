@@ -164,12 +164,15 @@ const struct sbi_platform_operations platform_ops = {
 
 	.console_init = ae350_console_init,
 	.console_putc = uart8250_putc,
+	.console_try_putc = uart8250_try_putc,
+	.console_puts = uart8250_puts,
 	.console_getc = uart8250_getc,
 
 	.irqchip_init = ae350_irqchip_init,
 
 	.ipi_init     = ae350_ipi_init,
 	.ipi_send     = plicsw_ipi_send,
+	.ipi_send_mask = plicsw_ipi_send_mask,
 	.ipi_clear    = plicsw_ipi_clear,
 
 	.timer_init	   = ae350_timer_init,
@@ -12,7 +12,7 @@
 #define _AE350_PLATFORM_H_
 
 #define AE350_HART_COUNT		4
-#define AE350_HART_STACK_SIZE		8192
+#define AE350_HART_STACK_SIZE		SBI_SCRATCH_HART_STACK_SIZE(8192)
 
 #define AE350_PLIC_ADDR			0xe4000000
 #define AE350_PLIC_NUM_SOURCES		71
@@ -78,6 +78,32 @@ void plicsw_ipi_send(u32 target_hart)
 	plic_sw_pending(target_hart);
 }
 
+void plicsw_ipi_send_mask(ulong mask, ulong base)
+{
+	/*
+	 * All targets of the current HART live in the same byte of
+	 * the pending array so set them with a single write.
+	 */
+	u32 source_hart = sbi_current_hartid();
+	u32 per_hart_offset = PLICSW_PENDING_PER_HART * source_hart;
+	u32 target_hart, val = 0;
+	ulong i;
+
+	for (i = 0; mask; i++, mask >>= 1) {
+		if (!(mask & 1UL))
+			continue;
+		target_hart = base + i;
+		if (plicsw_ipi_hart_count <= target_hart)
+			break;
+		val |= 1 << ((PLICSW_PENDING_PER_HART - 1) - target_hart);
+	}
+
+	/* Set PLICSW IPI */
+	if (val)
+		writel(val << per_hart_offset,
+		       plicsw_dev[source_hart].plicsw_pending);
+}
+
 void plicsw_ipi_clear(u32 target_hart)
 {
 	if (plicsw_ipi_hart_count <= target_hart)
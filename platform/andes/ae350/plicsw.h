@@ -35,6 +35,8 @@ struct plicsw {
 
 void plicsw_ipi_send(u32 target_hart);
 
+void plicsw_ipi_send_mask(ulong mask, ulong base);
+
 void plicsw_ipi_sync(u32 target_hart);
 
 void plicsw_ipi_clear(u32 target_hart);
@@ -181,10 +181,13 @@ const struct sbi_platform_operations platform_ops = {
 	.final_init = ariane_final_init,
 	.console_init = ariane_console_init,
 	.console_putc = uart8250_putc,
+	.console_try_putc = uart8250_try_putc,
+	.console_puts = uart8250_puts,
 	.console_getc = uart8250_getc,
 	.irqchip_init = ariane_irqchip_init,
 	.ipi_init = ariane_ipi_init,
 	.ipi_send = clint_ipi_send,
+	.ipi_send_mask = clint_ipi_send_mask,
 	.ipi_clear = clint_ipi_clear,
 	.timer_init = ariane_timer_init,
 	.timer_value = clint_timer_value,
@@ -200,7 +203,7 @@ const struct sbi_platform platform = {
 	.name = "ARIANE RISC-V",
 	.features = SBI_ARIANE_FEATURES,
 	.hart_count = ARIANE_HART_COUNT,
-	.hart_stack_size = 4096,
+	.hart_stack_size = SBI_SCRATCH_HART_STACK_SIZE(8192),
 	.disabled_hart_mask = 0,
 	.platform_ops_addr = (unsigned long)&platform_ops
 };
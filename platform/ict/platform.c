@@ -45,7 +45,7 @@
 #define UART_RXFIFO_EMPTY	(1 << UART_RXFIFO_EMPTY_BIT)
 #define UART_RXFIFO_DATA	0x000000ff
 
-#define SERVE_HART_STACK_SIZE		8192
+#define SERVE_HART_STACK_SIZE		SBI_SCRATCH_HART_STACK_SIZE(8192)
 
 #define SERVE_ENABLED_HART_MASK		((1 << SERVE_HART_COUNT) - 1)	
 
@@ -96,6 +96,15 @@ void serve_uart_putc(char ch)
 	set_reg(ch, UART_REG_TX_FIFO);
 }
 
+static int serve_uart_try_putc(char ch)
+{
+	if (get_reg(UART_REG_CH_STAT) & UART_TXFIFO_FULL)
+		return -1;
+
+	set_reg(ch, UART_REG_TX_FIFO);
+	return 0;
+}
+
 int serve_uart_getc(void)
 {
 	u32 ret = get_reg(UART_REG_CH_STAT);
@@ -107,31 +116,18 @@ int serve_uart_getc(void)
 	return -1;
 }
 
-static void sbi_Debug_puts(const char *str)
-{
-//        spin_lock(&console_out_lock);
-        while (*str) {
-//                sbi_putc(*str);
-		serve_uart_putc(*str);
-                str++;
-        }
-//        spin_unlock(&console_out_lock);
-}
-
 static int serve_early_init(bool cold_boot)
 {
 	if (!cold_boot)
 		return 0;
 
 	set_uart_base();
-	SPIN_LOCK_INIT(&pm_secure_lock);
-	sbi_Debug_puts("\n\rplatform/ict/platform.c: serve_early_init");
+	SPIN_LOCK_NAMED_INIT(&pm_secure_lock, "pm_secure");
 	return 0;
 }
 
 static int serve_final_init(bool cold_boot)
 {
-	sbi_Debug_puts("\n\rplatform/ict/platform.c: serve_final_init");
 	return 0;
 }
 
@@ -166,16 +162,13 @@ static int serve_irqchip_init(bool cold_boot)
 	int rc;
 	u32 hartid = sbi_current_hartid();
 
-	sbi_Debug_puts("\n\rplatform/ict/platform.c: serve_irqchip_init()");
 	if (cold_boot) {
-		sbi_Debug_puts("\n\rplatform/ict/platform.c: serve_irqchip_init: plic_cold_irqchip_init");
 		rc = plic_cold_irqchip_init(SERVE_PLIC_ADDR,
 						SERVE_PLIC_NUM_SOURCES,
 						SERVE_HART_COUNT);
 		if (rc)
 			return rc;
 	}
-	sbi_Debug_puts("\n\rplatform/ict/platform.c: serve_irqchip_init: plic_warm_irqchip_init");
 	return plic_warm_irqchip_init(hartid, (hartid) ? (2 * hartid - 1) : 0,
 					  (hartid) ? (2 * hartid) : -1);
 }
@@ -184,28 +177,22 @@ static int serve_ipi_init(bool cold_boot)
 {
 	int rc;
 
-	sbi_Debug_puts("\n\rplatform/ict/platform.c: serve_ipi_init()");
 	if (cold_boot) {
-		sbi_Debug_puts("\n\rplatform/ict/platform.c: serve_ipi_init: clint_cold_ipi_init");
 		rc = clint_cold_ipi_init(SERVE_CLINT_ADDR, SERVE_HART_COUNT);
 		if (rc)
 			return rc;
 	}
-	sbi_Debug_puts("\n\rplatform/ict/platform.c: serve_ipi_init: clint_warm_ipi_init");
 	return clint_warm_ipi_init();
 }
 
 static int serve_timer_init(bool cold_boot)
 {
 	int rc;
-	sbi_Debug_puts("\n\rplatform/ict/platform.c: serve_timer_init");
 	if (cold_boot) {
-		sbi_Debug_puts("\n\rplatform/ict/platform.c: serve_timer_init(): clint_cold_timer_init");
 		rc = clint_cold_timer_init(SERVE_CLINT_ADDR, SERVE_HART_COUNT);
 		if (rc)
 			return rc;
 	}
-	sbi_Debug_puts("\n\rplatform/ict/platform.c: serve_timer_init(): clint_warm_timer_init");
 	return clint_warm_timer_init();
 }
 
@@ -274,9 +261,11 @@ const struct sbi_platform_operations platform_ops = {
 	.early_init			= serve_early_init,
 	.final_init			= serve_final_init,
 	.console_putc		= serve_uart_putc,
+	.console_try_putc	= serve_uart_try_putc,
 	.console_getc		= serve_uart_getc,
 	.irqchip_init		= serve_irqchip_init,
 	.ipi_send		= clint_ipi_send,
+	.ipi_send_mask		= clint_ipi_send_mask,
 	.ipi_clear		= clint_ipi_clear,
 	.ipi_init		= serve_ipi_init,
 	.timer_value		= clint_timer_value,
@@ -115,12 +115,15 @@ static int k210_system_shutdown(u32 type)
 const struct sbi_platform_operations platform_ops = {
 	.console_init	= k210_console_init,
 	.console_putc	= sifive_uart_putc,
+	.console_try_putc = sifive_uart_try_putc,
+	.console_puts = sifive_uart_puts,
 	.console_getc	= sifive_uart_getc,
 
 	.irqchip_init = k210_irqchip_init,
 
 	.ipi_init  = k210_ipi_init,
 	.ipi_send  = clint_ipi_send,
+	.ipi_send_mask = clint_ipi_send_mask,
 	.ipi_clear = clint_ipi_clear,
 
 	.timer_init	   = k210_timer_init,
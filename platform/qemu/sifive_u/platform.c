@@ -18,7 +18,7 @@
 /* clang-format off */
 
 #define SIFIVE_U_HART_COUNT			4
-#define SIFIVE_U_HART_STACK_SIZE		8192
+#define SIFIVE_U_HART_STACK_SIZE		SBI_SCRATCH_HART_STACK_SIZE(8192)
 
 #define SIFIVE_U_SYS_CLK			1000000000
 #define SIFIVE_U_PERIPH_CLK			(SIFIVE_U_SYS_CLK / 2)
@@ -31,6 +31,7 @@
 
 #define SIFIVE_U_UART0_ADDR			0x10013000
 #define SIFIVE_U_UART1_ADDR			0x10023000
+#define SIFIVE_U_UART0_IRQ			4
 
 /* clang-format on */
 
@@ -93,6 +94,30 @@ static int sifive_u_irqchip_init(bool cold_boot)
 	return plic_warm_irqchip_init(hartid, (2 * hartid), (2 * hartid + 1));
 }
 
+static int sifive_u_console_irq_init(void)
+{
+	int rc = plic_mmode_enable(2 * sbi_current_hartid(),
+				   SIFIVE_U_UART0_IRQ);
+
+	/* No M-mode context for the UART, receive stays polled */
+	if (rc)
+		return SBI_ENOTSUPP;
+
+	sifive_uart_rx_irq_enable();
+
+	return SIFIVE_U_UART0_IRQ;
+}
+
+static u32 sifive_u_irqchip_claim(void)
+{
+	return plic_claim(2 * sbi_current_hartid());
+}
+
+static void sifive_u_irqchip_complete(u32 source)
+{
+	plic_complete(2 * sbi_current_hartid(), source);
+}
+
 static int sifive_u_ipi_init(bool cold_boot)
 {
 	int rc;
@@ -132,10 +157,16 @@ const struct sbi_platform_operations platform_ops = {
 	.pmp_region_info	= sifive_u_pmp_region_info,
 	.final_init		= sifive_u_final_init,
 	.console_putc		= sifive_uart_putc,
+	.console_try_putc	= sifive_uart_try_putc,
+	.console_puts		= sifive_uart_puts,
 	.console_getc		= sifive_uart_getc,
 	.console_init		= sifive_u_console_init,
+	.console_irq_init	= sifive_u_console_irq_init,
 	.irqchip_init		= sifive_u_irqchip_init,
+	.irqchip_claim		= sifive_u_irqchip_claim,
+	.irqchip_complete	= sifive_u_irqchip_complete,
 	.ipi_send		= clint_ipi_send,
+	.ipi_send_mask		= clint_ipi_send_mask,
 	.ipi_clear		= clint_ipi_clear,
 	.ipi_init		= sifive_u_ipi_init,
 	.timer_value		= clint_timer_value,
@@ -20,7 +20,7 @@
 /* clang-format off */
 
 #define VIRT_HART_COUNT			8
-#define VIRT_HART_STACK_SIZE		8192
+#define VIRT_HART_STACK_SIZE		SBI_SCRATCH_HART_STACK_SIZE(8192)
 
 #define VIRT_TEST_ADDR			0x100000
 #define VIRT_TEST_FINISHER_FAIL		0x3333
@@ -35,6 +35,7 @@
 #define VIRT_UART16550_ADDR		0x10000000
 #define VIRT_UART_BAUDRATE		115200
 #define VIRT_UART_SHIFTREG_ADDR		1843200
+#define VIRT_UART_IRQ			10
 
 /* clang-format on */
 
@@ -96,6 +97,29 @@ static int virt_irqchip_init(bool cold_boot)
 	return plic_warm_irqchip_init(hartid, (2 * hartid), (2 * hartid + 1));
 }
 
+static int virt_console_irq_init(void)
+{
+	int rc = plic_mmode_enable(2 * sbi_current_hartid(), VIRT_UART_IRQ);
+
+	/* No M-mode context for the UART, receive stays polled */
+	if (rc)
+		return SBI_ENOTSUPP;
+
+	uart8250_rx_irq_enable();
+
+	return VIRT_UART_IRQ;
+}
+
+static u32 virt_irqchip_claim(void)
+{
+	return plic_claim(2 * sbi_current_hartid());
+}
+
+static void virt_irqchip_complete(u32 source)
+{
+	plic_complete(2 * sbi_current_hartid(), source);
+}
+
 static int virt_ipi_init(bool cold_boot)
 {
 	int rc;
@@ -137,10 +161,16 @@ const struct sbi_platform_operations platform_ops = {
 	.pmp_region_info	= virt_pmp_region_info,
 	.final_init		= virt_final_init,
 	.console_putc		= uart8250_putc,
+	.console_try_putc	= uart8250_try_putc,
+	.console_puts		= uart8250_puts,
 	.console_getc		= uart8250_getc,
 	.console_init		= virt_console_init,
+	.console_irq_init	= virt_console_irq_init,
 	.irqchip_init		= virt_irqchip_init,
+	.irqchip_claim		= virt_irqchip_claim,
+	.irqchip_complete	= virt_irqchip_complete,
 	.ipi_send		= clint_ipi_send,
+	.ipi_send_mask		= clint_ipi_send_mask,
 	.ipi_clear		= clint_ipi_clear,
 	.ipi_init		= virt_ipi_init,
 	.timer_value		= clint_timer_value,
@@ -22,7 +22,7 @@
 /* clang-format off */
 
 #define FU540_HART_COUNT			5
-#define FU540_HART_STACK_SIZE			8192
+#define FU540_HART_STACK_SIZE			SBI_SCRATCH_HART_STACK_SIZE(8192)
 
 #define FU540_SYS_CLK				1000000000
 
@@ -35,6 +35,7 @@
 #define FU540_UART0_ADDR			0x10010000
 #define FU540_UART1_ADDR			0x10011000
 #define FU540_UART_BAUDRATE			115200
+#define FU540_UART0_IRQ				4
 
 /**
  * The FU540 SoC has 5 HARTs but HART ID 0 doesn't have S mode. enable only
@@ -141,6 +142,36 @@ static int fu540_console_init(void)
 				FU540_UART_BAUDRATE);
 }
 
+/* HART 0 only has an M-mode context, the others have M and S */
+static u32 fu540_plic_m_cntx_id(u32 hartid)
+{
+	return (hartid) ? (2 * hartid - 1) : 0;
+}
+
+static int fu540_console_irq_init(void)
+{
+	int rc = plic_mmode_enable(fu540_plic_m_cntx_id(sbi_current_hartid()),
+				   FU540_UART0_IRQ);
+
+	/* No M-mode context for the UART, receive stays polled */
+	if (rc)
+		return SBI_ENOTSUPP;
+
+	sifive_uart_rx_irq_enable();
+
+	return FU540_UART0_IRQ;
+}
+
+static u32 fu540_irqchip_claim(void)
+{
+	return plic_claim(fu540_plic_m_cntx_id(sbi_current_hartid()));
+}
+
+static void fu540_irqchip_complete(u32 source)
+{
+	plic_complete(fu540_plic_m_cntx_id(sbi_current_hartid()), source);
+}
+
 static int fu540_irqchip_init(bool cold_boot)
 {
 	int rc;
@@ -154,7 +185,7 @@ static int fu540_irqchip_init(bool cold_boot)
 			return rc;
 	}
 
-	return plic_warm_irqchip_init(hartid, (hartid) ? (2 * hartid - 1) : 0,
+	return plic_warm_irqchip_init(hartid, fu540_plic_m_cntx_id(hartid),
 				      (hartid) ? (2 * hartid) : -1);
 }
 
@@ -195,10 +226,16 @@ const struct sbi_platform_operations platform_ops = {
 	.pmp_region_info	= fu540_pmp_region_info,
 	.final_init		= fu540_final_init,
 	.console_putc		= sifive_uart_putc,
+	.console_try_putc	= sifive_uart_try_putc,
+	.console_puts		= sifive_uart_puts,
 	.console_getc		= sifive_uart_getc,
 	.console_init		= fu540_console_init,
+	.console_irq_init	= fu540_console_irq_init,
 	.irqchip_init		= fu540_irqchip_init,
+	.irqchip_claim		= fu540_irqchip_claim,
+	.irqchip_complete	= fu540_irqchip_complete,
 	.ipi_send		= clint_ipi_send,
+	.ipi_send_mask		= clint_ipi_send_mask,
 	.ipi_clear		= clint_ipi_clear,
 	.ipi_init		= fu540_ipi_init,
 	.timer_value		= clint_timer_value,
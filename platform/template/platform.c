@@ -124,6 +124,15 @@ static void platform_ipi_send(u32 target_hart)
 	clint_ipi_send(target_hart);
 }
 
+/*
+ * Send IPI to a set of target HARTs (optional, batches doorbells).
+ */
+static void platform_ipi_send_mask(ulong mask, ulong base)
+{
+	/* Example if the generic CLINT driver is used */
+	clint_ipi_send_mask(mask, base);
+}
+
 /*
  * Clear IPI for a target HART.
  */
@@ -207,6 +216,7 @@ const struct sbi_platform_operations platform_ops = {
 	.console_init		= platform_console_init,
 	.irqchip_init		= platform_irqchip_init,
 	.ipi_send		= platform_ipi_send,
+	.ipi_send_mask		= platform_ipi_send_mask,
 	.ipi_clear		= platform_ipi_clear,
 	.ipi_init		= platform_ipi_init,
 	.timer_value		= platform_timer_value,
@@ -222,8 +232,9 @@ const struct sbi_platform platform = {
 	.name			= "platform-name",
 	.features		= SBI_PLATFORM_DEFAULT_FEATURES,
 	.hart_count		= 1,
-	.hart_stack_size	= 4096,
+	.hart_stack_size	= SBI_SCRATCH_HART_STACK_SIZE(8192),
 	.disabled_hart_mask	= 0,
+	/* Zero means calibrate TLB range flush limit at boot time */
 	.tlb_range_flush_limit	= 0,
 	.platform_ops_addr	= (unsigned long)&platform_ops
 };
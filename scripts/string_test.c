@@ -0,0 +1,298 @@
+/*
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Host test and benchmark for the sbi_string mem routines
+ *
+ * Built and run by "make string-test", which passes STRING_TEST_ARGS
+ * ("[seed] [--no-bench]") to the binary. The routines of
+ * lib/sbi/sbi_string.c are checked against the host libc over random lengths, alignments and
+ * overlaps, then timed against the plain byte loops they replaced.
+ *
+ * The OpenSBI headers clash with the host libc headers, so the routines
+ * under test are declared here instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void *sbi_memset(void *s, int c, size_t count);
+void *sbi_memcpy(void *dest, const void *src, size_t count);
+void *sbi_memmove(void *dest, const void *src, size_t count);
+int sbi_memcmp(const void *s1, const void *s2, size_t count);
+
+#define BUF_SIZE		8192
+#define GUARD			64
+#define MAX_OFFSET		64
+#define MAX_LEN			512
+/* Bytes a random test can touch, with an untouched guard after them */
+#define TEST_SPAN		(GUARD + MAX_OFFSET + MAX_LEN + GUARD)
+#define TEST_ITERATIONS		1000000
+#define BENCH_BYTES		(64UL << 20)
+
+static unsigned char ref_buf[BUF_SIZE], test_buf[BUF_SIZE];
+static unsigned char src_buf[BUF_SIZE];
+
+/* Byte loop versions, as sbi_string.c had them before word accesses */
+static void *byte_memset(void *s, int c, size_t count)
+{
+	char *temp = s;
+
+	while (count > 0) {
+		count--;
+		*temp++ = c;
+	}
+
+	return s;
+}
+
+static void *byte_memcpy(void *dest, const void *src, size_t count)
+{
+	char *temp1	  = dest;
+	const char *temp2 = src;
+
+	while (count > 0) {
+		*temp1++ = *temp2++;
+		count--;
+	}
+
+	return dest;
+}
+
+static void *byte_memmove(void *dest, const void *src, size_t count)
+{
+	char *temp1	  = (char *)dest;
+	const char *temp2 = (char *)src;
+
+	if (src == dest)
+		return dest;
+
+	if (dest < src) {
+		while (count > 0) {
+			*temp1++ = *temp2++;
+			count--;
+		}
+	} else {
+		temp1 = dest + count - 1;
+		temp2 = src + count - 1;
+
+		while (count > 0) {
+			*temp1-- = *temp2--;
+			count--;
+		}
+	}
+
+	return dest;
+}
+
+static int byte_memcmp(const void *s1, const void *s2, size_t count)
+{
+	const char *temp1 = s1;
+	const char *temp2 = s2;
+
+	for (; count > 0 && (*temp1 == *temp2); count--) {
+		temp1++;
+		temp2++;
+	}
+
+	if (count > 0)
+		return *(unsigned char *)temp1 - *(unsigned char *)temp2;
+	else
+		return 0;
+}
+
+static int sign(int v)
+{
+	return (v > 0) - (v < 0);
+}
+
+static void fill_random(unsigned char *buf, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = rand();
+}
+
+static int check_bufs(const char *name, unsigned long iter, size_t doff,
+		      size_t soff, size_t len)
+{
+	if (!memcmp(ref_buf, test_buf, TEST_SPAN))
+		return 0;
+
+	printf("FAIL %s: iteration %lu dest +%zu src +%zu len %zu\n",
+	       name, iter, doff, soff, len);
+	return 1;
+}
+
+static int test_one(unsigned long iter)
+{
+	size_t len  = rand() % MAX_LEN;
+	size_t doff = GUARD + rand() % MAX_OFFSET;
+	size_t soff = GUARD + rand() % MAX_OFFSET;
+	int c = rand() & 0xff;
+	unsigned char *a, *b;
+
+	fill_random(ref_buf, TEST_SPAN);
+	memcpy(test_buf, ref_buf, TEST_SPAN);
+
+	switch (iter % 5) {
+	case 0:
+		if (sbi_memset(test_buf + doff, c, len) != test_buf + doff)
+			goto bad_ret;
+		memset(ref_buf + doff, c, len);
+		return check_bufs("memset", iter, doff, soff, len);
+	case 1:
+		fill_random(src_buf, TEST_SPAN);
+		if (sbi_memcpy(test_buf + doff, src_buf + soff, len) !=
+		    test_buf + doff)
+			goto bad_ret;
+		memcpy(ref_buf + doff, src_buf + soff, len);
+		return check_bufs("memcpy", iter, doff, soff, len);
+	case 2:
+	case 3:
+		/* Source and destination within the same buffer may overlap */
+		if (sbi_memmove(test_buf + doff, test_buf + soff, len) !=
+		    test_buf + doff)
+			goto bad_ret;
+		memmove(ref_buf + doff, ref_buf + soff, len);
+		return check_bufs("memmove", iter, doff, soff, len);
+	default:
+		a = ref_buf + doff;
+		b = test_buf + soff;
+		memcpy(b, a, len);
+		/* Half of the compares differ in one random bit */
+		if (len && (rand() & 1))
+			b[rand() % len] ^= 1 << (rand() % 8);
+		if (sign(sbi_memcmp(a, b, len)) == sign(memcmp(a, b, len)))
+			return 0;
+		printf("FAIL memcmp: iteration %lu a +%zu b +%zu len %zu\n",
+		       iter, doff, soff, len);
+		return 1;
+	}
+
+bad_ret:
+	printf("FAIL: iteration %lu did not return dest\n", iter);
+	return 1;
+}
+
+typedef void *(*copy_fn)(void *, const void *, size_t);
+typedef void *(*set_fn)(void *, int, size_t);
+typedef int (*cmp_fn)(const void *, const void *, size_t);
+
+struct bench_impl {
+	const char *name;
+	set_fn set;
+	copy_fn copy;
+	copy_fn move;
+	cmp_fn cmp;
+};
+
+static const struct bench_impl bench_impls[] = {
+	{ "sbi", sbi_memset, sbi_memcpy, sbi_memmove, sbi_memcmp },
+	{ "byte", byte_memset, byte_memcpy, byte_memmove, byte_memcmp },
+	{ "libc", memset, memcpy, memmove, memcmp },
+};
+
+/* Keeps the compiler from dropping benchmarked calls */
+static volatile int bench_sink;
+
+static double now_sec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double bench_one(const struct bench_impl *impl, int op, size_t len,
+			size_t doff, size_t soff)
+{
+	unsigned long i, loops = BENCH_BYTES / len;
+	unsigned char *dest = test_buf + doff;
+	unsigned char *src = src_buf + soff;
+	double start;
+
+	memcpy(dest, src, len);
+	start = now_sec();
+	for (i = 0; i < loops; i++) {
+		switch (op) {
+		case 0:
+			impl->set(dest, i, len);
+			break;
+		case 1:
+			impl->copy(dest, src, len);
+			break;
+		case 2:
+			/* Overlapping move by 16 bytes, alternating direction */
+			if (i & 1)
+				impl->move(dest + 16, dest + soff, len);
+			else
+				impl->move(dest + soff, dest + 16, len);
+			break;
+		default:
+			bench_sink += impl->cmp(dest, src, len);
+			break;
+		}
+	}
+
+	return (BENCH_BYTES >> 20) / (now_sec() - start);
+}
+
+static void bench(void)
+{
+	static const char *const ops[] = { "memset", "memcpy", "memmove",
+					   "memcmp" };
+	static const size_t lens[] = { 16, 64, 256, 1024, 4096 };
+	size_t i, l, a, soff;
+	int op;
+
+	printf("\n%-8s %-9s %6s", "routine", "alignment", "bytes");
+	for (i = 0; i < sizeof(bench_impls) / sizeof(bench_impls[0]); i++)
+		printf(" %8s MB/s", bench_impls[i].name);
+	printf("\n");
+
+	for (op = 0; op < 4; op++) {
+		for (a = 0; a < 2; a++) {
+			/* Mutually misaligned buffers fall back to bytes */
+			soff = (a) ? 3 : 0;
+			for (l = 0; l < sizeof(lens) / sizeof(lens[0]); l++) {
+				printf("%-8s %-9s %6zu", ops[op],
+				       (a) ? "mutual+3" : "aligned", lens[l]);
+				for (i = 0; i < sizeof(bench_impls) /
+						sizeof(bench_impls[0]); i++)
+					printf(" %13.0f",
+					       bench_one(&bench_impls[i], op,
+							 lens[l], 0, soff));
+				printf("\n");
+			}
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long i, seed = 1;
+	int run_bench = 1;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--no-bench"))
+			run_bench = 0;
+		else
+			seed = strtoul(argv[i], NULL, 0);
+	}
+	srand(seed);
+
+	for (i = 0; i < TEST_ITERATIONS; i++) {
+		if (test_one(i))
+			return 1;
+	}
+	printf("sbi_string: %d random mem routine tests passed\n",
+	       TEST_ITERATIONS);
+
+	if (run_bench)
+		bench();
+
+	return 0;
+}